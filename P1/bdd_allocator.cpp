@@ -0,0 +1,95 @@
+/*
+ * File bdd_allocator.cpp
+ *
+ * Contains the implementation of the class methods of bdd_allocator,
+ * defined in bdd_allocator.h
+ */
+
+#include "bdd_allocator.h"
+#include <new>
+#include <cassert>
+
+using namespace std;
+
+const int bdd_allocator::chunk_bits;
+const int bdd_allocator::chunk_size;
+
+bdd_allocator::bdd_allocator(size_t size) :
+  // a free slot must be able to hold the index of the next one
+  slot_size(size < sizeof(int) ? sizeof(int) : size),
+  free_head(-1), next_unused(0), live(0)
+{
+}
+
+bdd_allocator::~bdd_allocator()
+{
+  for (size_t i = 0; i < chunks.size(); ++i)
+  {
+    ::operator delete(chunks[i]);
+  }
+}
+
+// pops a slot off the free list, or takes the next unused one, adding a
+// chunk when all of them are in use
+void* bdd_allocator::allocate(int& id)
+{
+  void* p;
+  if (free_head >= 0)
+  {
+    id = free_head;
+    p = slot(id);
+    free_head = *static_cast<int*>(p);
+  }
+  else
+  {
+    if (next_unused == (int)capacity())
+    {
+      chunks.push_back(static_cast<char*>(::operator new(chunk_size * slot_size)));
+    }
+    id = next_unused++;
+    p = slot(id);
+  }
+  ++live;
+  return p;
+}
+
+void bdd_allocator::reset_free_list(const vector<bool>& used)
+{
+  int last = -1;
+  live = 0;
+  for (int id = 0; id < next_unused && id < (int)used.size(); ++id)
+  {
+    if (used[id])
+    {
+      last = id;
+      ++live;
+    }
+  }
+
+  next_unused = last + 1;
+  size_t needed = (next_unused + chunk_size - 1) / chunk_size;
+  while (chunks.size() > needed)
+  {
+    ::operator delete(chunks.back());
+    chunks.pop_back();
+  }
+
+  free_head = -1;
+  for (int id = next_unused - 1; id >= 0; --id)
+  {
+    if (!used[id])
+    {
+      *static_cast<int*>(slot(id)) = free_head;
+      free_head = id;
+    }
+  }
+}
+
+void bdd_allocator::release(int id)
+{
+  assert(id >= 0 && id < next_unused && live > 0);
+
+  *static_cast<int*>(slot(id)) = free_head;
+  free_head = id;
+  --live;
+}
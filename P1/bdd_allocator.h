@@ -0,0 +1,72 @@
+#ifndef BDD_ALLOCATOR_H
+#define BDD_ALLOCATOR_H
+
+/*
+ * File bdd_allocator.h
+ *
+ * Defines the class bdd_allocator, the slab allocator that provides the
+ * memory for bdd_nodes and hands out their ids
+ */
+
+#include <vector>
+#include <cstddef>
+
+// bdd_allocator hands out fixed size slots from chunks of chunk_size
+// slots each.  A slot's index (chunk number * chunk_size + position in the
+// chunk) is the id of the node that lives in it, so the address of a node
+// can be computed from its id and vice versa.
+//
+// Slots are handed out in index order.  When a node is released its slot
+// goes on a free list that is threaded through the dead slots themselves
+// (the first bytes of a free slot hold the index of the next free slot), and
+// the next allocation reuses it.  Chunks are never returned, only when the
+// allocator is destroyed.
+class bdd_allocator
+{
+public:
+  // slot_size is the size in bytes of an object
+  bdd_allocator(size_t slot_size);
+  ~bdd_allocator();
+
+  // returns raw storage for one object, and its index in id
+  void* allocate(int& id);
+
+  // puts the slot with index id back on the free list.  the object in it
+  // must already be destroyed
+  void release(int id);
+
+  // makes the slots marked in used (indexed by id) the ones in use, after
+  // their objects were moved around, and puts the others on the free list
+  // in index order, so they are handed out lowest first.  the chunks past
+  // the last slot in use are freed
+  void reset_free_list(const std::vector<bool>& used);
+
+  // address of the slot with index id
+  void* slot(int id) const
+  {
+    return chunks[id >> chunk_bits] + (size_t)(id & (chunk_size - 1)) * slot_size;
+  }
+
+  // number of slots in use
+  unsigned int live_count() const { return live; }
+
+  // number of slots in all chunks
+  unsigned int capacity() const { return chunks.size() * chunk_size; }
+
+  static const int chunk_bits = 12;
+  static const int chunk_size = 1 << chunk_bits;
+
+private:
+  // dissallow copy and assignment
+  bdd_allocator(const bdd_allocator&);
+  bdd_allocator& operator=(const bdd_allocator&);
+
+  size_t slot_size;
+  std::vector<char*> chunks;
+
+  int free_head;     // index of the first free slot, -1 if there is none
+  int next_unused;   // index of the first slot never handed out
+  unsigned int live; // number of slots in use
+};
+
+#endif
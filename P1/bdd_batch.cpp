@@ -0,0 +1,838 @@
+/*
+ * File bdd_batch.cpp
+ *
+ * Contains the implementation of the batch mode and the benchmark
+ * generators, declared in bdd_batch.h
+ */
+
+#include "bdd_batch.h"
+#include "project1.h"
+#include "bdd_io.h"
+#include "bdd_compiler.h"
+#include "bdd_zdd.h"
+#include "bdd_truth_table.h"
+#include "bdd_netlist.h"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <map>
+#include <set>
+#include <vector>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+using namespace std;
+
+// name -> result
+typedef map<string, bdd_ptr> result_map;
+
+// what the statements of one operation took
+struct op_stats
+{
+  op_stats() : count(0), total(0), max(0) {}
+
+  unsigned int count;
+  double total; // seconds
+  double max;
+};
+
+// wall clock time in seconds
+static double now()
+{
+  timeval tv;
+  gettimeofday(&tv, 0);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+// the largest resident set size of the process so far, in kilobytes
+static long peak_memory_kb()
+{
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+// number of nodes in f, the terminal included
+static unsigned int node_count(const bdd_ptr& f)
+{
+  set<bdd_node*> visited;
+  vector<bdd_node*> stack(1, f.node());
+  while (!stack.empty())
+  {
+    bdd_node* n = stack.back();
+    stack.pop_back();
+
+    if (!visited.insert(n).second || n->is_terminal()) continue;
+    stack.push_back(n->neg_cf.node());
+    stack.push_back(n->pos_cf.node());
+  }
+  return visited.size();
+}
+
+// the var named name.  throws unknown_name_error if there is none
+static int declared_var(const string& name)
+{
+  int var = bdd_tables::getInstance().find_var(name);
+  if (var < 0) throw unknown_name_error(0, name);
+  return var;
+}
+
+// the BDD an operand stands for: a result, a constant or a var.  throws
+// unknown_name_error if it is none of these
+static bdd_ptr operand(const result_map& results, const string& name)
+{
+  result_map::const_iterator it = results.find(name);
+  if (it != results.end()) return it->second;
+
+  if (name == "0") return bdd_node::zero();
+  if (name == "1") return bdd_node::one();
+
+  return bdd_tables::getInstance().var_bdd(declared_var(name));
+}
+
+// the ZDD an operand of a ZDD statement stands for: a result or a
+// constant.  a var stands for its BDD, so it is no ZDD.  returns a null
+// bdd_ptr, with a message in error, if the operand isn't a ZDD
+static bdd_ptr zdd_operand(const result_map& results, const string& name, string& error)
+{
+  if (!results.count(name) && name != "0" && name != "1")
+  {
+    declared_var(name);
+    error = name + " is a var, not a ZDD";
+    return bdd_ptr();
+  }
+  bdd_ptr p = operand(results, name);
+  if (!is_zdd(p))
+  {
+    error = name + " isn't a ZDD";
+    return bdd_ptr();
+  }
+  return p;
+}
+
+// the BDD an operand of isop stands for.  returns a null bdd_ptr, with a
+// message in error, if it is a ZDD
+static bdd_ptr bdd_operand(const result_map& results, const string& name, string& error)
+{
+  bdd_ptr f = operand(results, name);
+  if (!is_bdd(f))
+  {
+    error = name + " isn't a BDD";
+    return bdd_ptr();
+  }
+  return f;
+}
+
+// runs the statement cmd, whose arguments are read from args.  returns
+// false, with a message in error, if the statement is malformed.  a name
+// that stands for nothing throws unknown_name_error.
+// otherwise, if the statement has a result it is stored under its name and
+// returned in result, and anything it prints goes to output
+static bool run_statement(const string& cmd, istringstream& args, result_map& results,
+                          bdd_ptr& result, ostream& output, string& error)
+{
+  string name, a, b;
+
+  if (cmd == "inputs")
+  {
+    bdd_tables& tables = bdd_tables::getInstance();
+    while (args >> name) tables.add_var(name);
+    if (name.empty())
+    {
+      error = "usage: inputs VAR...";
+      return false;
+    }
+    name.clear();
+  }
+  else if (cmd == "let")
+  {
+    string expr_text;
+    if (!(args >> name) || !getline(args, expr_text))
+    {
+      error = "usage: let NAME EXPR";
+      return false;
+    }
+
+    try
+    {
+      result = compile_expr(expr_text, results, false);
+    }
+    catch (BoolExprParser::Error& err)
+    {
+      ostringstream msg;
+      msg << "column " << err.index + 1 << ": parse error #" << err.code;
+      error = msg.str();
+      return false;
+    }
+    catch (unknown_name_error& err)
+    {
+      ostringstream msg;
+      msg << "column " << err.index + 1 << ": unknown name " << err.name;
+      error = msg.str();
+      return false;
+    }
+  }
+  else if (cmd == "apply")
+  {
+    string op_name;
+    operation op;
+    if (!(args >> name >> op_name >> a >> b) || !op.set_operation(op_name))
+    {
+      error = "usage: apply NAME and|or|xor A B";
+      return false;
+    }
+    result = apply(operand(results, a), operand(results, b), op);
+  }
+  else if (cmd == "cofactor")
+  {
+    int value;
+    if (!(args >> name >> a >> b >> value) || (value != 0 && value != 1))
+    {
+      error = "usage: cofactor NAME A VAR 0|1";
+      return false;
+    }
+    int var = declared_var(b);
+    bdd_ptr f = operand(results, a);
+    result = value ? positive_cofactor(f, var) : negative_cofactor(f, var);
+  }
+  else if (cmd == "diff")
+  {
+    if (!(args >> name >> a >> b))
+    {
+      error = "usage: diff NAME A VAR";
+      return false;
+    }
+    int var = declared_var(b);
+    result = boolean_difference(operand(results, a), var);
+  }
+  else if (cmd == "exists" || cmd == "forall")
+  {
+    if (!(args >> name >> a >> b))
+    {
+      error = "usage: " + cmd + " NAME A CUBE";
+      return false;
+    }
+    bdd_ptr f = operand(results, a);
+    bdd_ptr cube = operand(results, b);
+    result = (cmd == "exists") ? exists(f, cube) : forall(f, cube);
+    if (!result)
+    {
+      error = b + " isn't a conjunction of vars";
+      return false;
+    }
+  }
+  else if (cmd == "andex")
+  {
+    string c;
+    if (!(args >> name >> a >> b >> c))
+    {
+      error = "usage: andex NAME A B CUBE";
+      return false;
+    }
+    result = and_exists(operand(results, a), operand(results, b), operand(results, c));
+    if (!result)
+    {
+      error = c + " isn't a conjunction of vars";
+      return false;
+    }
+  }
+  else if (cmd == "support")
+  {
+    if (!(args >> name >> a))
+    {
+      error = "usage: support NAME A";
+      return false;
+    }
+    result = support_cube(operand(results, a));
+  }
+  else if (cmd == "compose")
+  {
+    if (!(args >> name >> a))
+    {
+      error = "usage: compose NAME A VAR B...";
+      return false;
+    }
+    bdd_ptr f = operand(results, a);
+    bdd_tables& tables = bdd_tables::getInstance();
+
+    vector<pair<int, bdd_ptr> > pairs;
+    string var;
+    while (args >> var)
+    {
+      if (!(args >> b))
+      {
+        error = "usage: compose NAME A VAR B...";
+        return false;
+      }
+      pairs.push_back(make_pair(declared_var(var), operand(results, b)));
+    }
+    if (pairs.size() == 1)
+    {
+      result = compose(f, pairs[0].first, pairs[0].second);
+    }
+    else
+    {
+      vector<bdd_ptr> subst(tables.num_vars());
+      for (size_t i = 0; i < pairs.size(); ++i)
+      {
+        subst[pairs[i].first] = pairs[i].second;
+      }
+      result = vector_compose(f, subst);
+    }
+  }
+  else if (cmd == "isop")
+  {
+    if (!(args >> name >> a))
+    {
+      error = "usage: isop NAME A [B]";
+      return false;
+    }
+    bdd_ptr lower = bdd_operand(results, a, error);
+    if (!lower) return false;
+    bdd_ptr upper = lower;
+    if (args >> b)
+    {
+      upper = bdd_operand(results, b, error);
+      if (!upper) return false;
+    }
+    result = isop(lower, upper);
+  }
+  else if (cmd == "zunion" || cmd == "zinter" || cmd == "zdiff" || cmd == "zprod")
+  {
+    if (!(args >> name >> a >> b))
+    {
+      error = "usage: " + cmd + " NAME P Q";
+      return false;
+    }
+    bdd_ptr p = zdd_operand(results, a, error);
+    if (!p) return false;
+    bdd_ptr q = zdd_operand(results, b, error);
+    if (!q) return false;
+    if (cmd == "zunion") result = zdd_union(p, q);
+    else if (cmd == "zinter") result = zdd_intersect(p, q);
+    else if (cmd == "zdiff") result = zdd_diff(p, q);
+    else result = zdd_product(p, q);
+  }
+  else if (cmd == "function")
+  {
+    if (!(args >> name >> a))
+    {
+      error = "usage: function NAME P";
+      return false;
+    }
+    bdd_ptr p = zdd_operand(results, a, error);
+    if (!p) return false;
+    result = cover_function(p);
+    if (!result)
+    {
+      error = a + " isn't a cover: it has vars that are no literals";
+      return false;
+    }
+  }
+  else if (cmd == "cover")
+  {
+    if (!(args >> a))
+    {
+      error = "usage: cover P";
+      return false;
+    }
+    bdd_ptr p = zdd_operand(results, a, error);
+    if (!p) return false;
+    output << "  " << zdd_count(p) << " cubes: ";
+    print_cover(output, p);
+    output << endl;
+  }
+  else if (cmd == "sort")
+  {
+    if (!(args >> name >> a))
+    {
+      error = "usage: sort NAME A";
+      return false;
+    }
+    result = sort_by_influence(operand(results, a));
+  }
+  else if (cmd == "influence")
+  {
+    if (!(args >> a))
+    {
+      error = "usage: influence A";
+      return false;
+    }
+    vector<double> infl = influence(operand(results, a));
+    bdd_tables& tables = bdd_tables::getInstance();
+    for (size_t var = 0; var < infl.size(); ++var)
+    {
+      if (infl[var] > 0) output << "  " << tables.var_name(var) << ": " << infl[var] << endl;
+    }
+  }
+  else if (cmd == "count")
+  {
+    if (!(args >> a))
+    {
+      error = "usage: count A [VAR P]...";
+      return false;
+    }
+    bdd_ptr f = operand(results, a);
+    bdd_tables& tables = bdd_tables::getInstance();
+
+    vector<pair<int, double> > weights;
+    string var;
+    double p;
+    while (args >> var)
+    {
+      if (!(args >> p) || p < 0 || p > 1)
+      {
+        error = "usage: count A [VAR P]..., where 0 <= P <= 1";
+        return false;
+      }
+      weights.push_back(make_pair(declared_var(var), p));
+    }
+    vector<double> var_prob(tables.num_vars(), 0.5);
+    for (size_t i = 0; i < weights.size(); ++i)
+    {
+      var_prob[weights[i].first] = weights[i].second;
+    }
+    output << "  models: " << sat_count(f) << ", probability: " << probability(f, var_prob) << endl;
+  }
+  else if (cmd == "reorder")
+  {
+    bdd_tables::reorder_stats stats = bdd_tables::getInstance().reorder();
+    output << "  sifting: " << stats.nodes_before << " -> " << stats.nodes_after
+           << " nodes" << endl;
+  }
+  else if (cmd == "autoreorder")
+  {
+    string mode;
+    if (!(args >> mode) || (mode != "on" && mode != "off"))
+    {
+      error = "usage: autoreorder on|off";
+      return false;
+    }
+    bdd_tables::getInstance().set_reordering(mode == "on");
+  }
+  else if (cmd == "compact")
+  {
+    bdd_tables::compact_stats stats = bdd_tables::getInstance().compact();
+    output << "  compaction: " << stats.moved << " of " << stats.nodes << " nodes moved, "
+           << stats.slots_before << " -> " << stats.slots_after << " slots" << endl;
+  }
+  else if (cmd == "truthtable")
+  {
+    int levels;
+    if (!(args >> levels))
+    {
+      error = "usage: truthtable N";
+      return false;
+    }
+    bdd_tables::getInstance().set_truth_table_threshold(levels);
+  }
+  else if (cmd == "print")
+  {
+    if (!(args >> a))
+    {
+      error = "usage: print A";
+      return false;
+    }
+    output << operand(results, a) << endl;
+  }
+  else if (cmd == "save")
+  {
+    string path;
+    vector<bdd_ptr> roots;
+    if (!(args >> path))
+    {
+      error = "usage: save FILE A...";
+      return false;
+    }
+    while (args >> a)
+    {
+      roots.push_back(operand(results, a));
+    }
+    if (!save_bdds(path, roots, error)) return false;
+  }
+  else if (cmd == "dot" || cmd == "blif" || cmd == "table")
+  {
+    string path;
+    vector<string> names;
+    vector<bdd_ptr> roots;
+    if (cmd != "table" && !(args >> path))
+    {
+      error = "usage: " + cmd + " FILE A...";
+      return false;
+    }
+    while (args >> a)
+    {
+      names.push_back(a);
+      roots.push_back(operand(results, a));
+    }
+
+    if (cmd == "table")
+    {
+      write_node_table(output, roots, names);
+    }
+    else
+    {
+      ofstream os(path.c_str());
+      if (cmd == "dot") write_dot(os, roots, names);
+      else write_blif(os, roots, names);
+      os.close();
+      if (!os)
+      {
+        error = "can't write " + path;
+        return false;
+      }
+    }
+  }
+  else if (cmd == "load")
+  {
+    string path;
+    vector<string> names;
+    vector<bdd_ptr> roots;
+    if (!(args >> path))
+    {
+      error = "usage: load FILE NAME...";
+      return false;
+    }
+    while (args >> name)
+    {
+      names.push_back(name);
+    }
+    name.clear();
+    if (!load_bdds(path, roots, error)) return false;
+    if (roots.size() != names.size())
+    {
+      ostringstream msg;
+      msg << path << " has " << roots.size() << " BDDs, " << names.size() << " names given";
+      error = msg.str();
+      return false;
+    }
+    for (size_t i = 0; i < roots.size(); ++i)
+    {
+      results[names[i]] = roots[i];
+    }
+  }
+  else if (cmd == "netlist")
+  {
+    string path;
+    unsigned int budget = 0;
+    if (!(args >> path) || (!(args >> budget) && !args.eof()))
+    {
+      error = "usage: netlist FILE [BUDGET]";
+      return false;
+    }
+
+    vector<netlist_output> outputs;
+    netlist_stats stats;
+    bool ok = load_netlist(path, budget, outputs, stats, error);
+    for (size_t i = 0; i < outputs.size(); ++i)
+    {
+      results[outputs[i].name] = outputs[i].bdd;
+    }
+    if (!ok) return false;
+    print_netlist_stats(output, outputs, stats);
+  }
+  else if (cmd == "free")
+  {
+    if (!(args >> name) || !results.erase(name))
+    {
+      error = "usage: free NAME, where NAME is a result";
+      return false;
+    }
+    name.clear();
+  }
+  else
+  {
+    error = "unknown statement " + cmd;
+    return false;
+  }
+
+  if (result)
+  {
+    results[name] = result;
+  }
+  return true;
+}
+
+int run_batch(istream& is, ostream& os)
+{
+  bdd_tables& tables = bdd_tables::getInstance();
+  result_map results;
+  map<string, op_stats> stats;
+  int failed = 0;
+  double start = now();
+
+  os << setw(6) << "line" << setw(10) << "op" << setw(12) << "time (s)"
+     << setw(10) << "nodes" << setw(10) << "lookups" << setw(8) << "hit %" << endl;
+
+  string line;
+  for (int line_no = 1; getline(is, line); ++line_no)
+  {
+    istringstream args(line);
+    string cmd;
+    if (!(args >> cmd) || cmd[0] == '#') continue;
+
+    unsigned long lookups = tables.computed_lookup_count();
+    unsigned long hits = tables.computed_hit_count();
+
+    bdd_ptr result;
+    ostringstream output;
+    string error;
+
+    double op_start = now();
+    bool ok;
+    try
+    {
+      ok = run_statement(cmd, args, results, result, output, error);
+    }
+    catch (unknown_name_error& err)
+    {
+      error = "unknown name " + err.name;
+      ok = false;
+    }
+    double seconds = now() - op_start;
+
+    if (!ok)
+    {
+      os << "line " << line_no << ": " << error << endl;
+      ++failed;
+      continue;
+    }
+
+    lookups = tables.computed_lookup_count() - lookups;
+    hits = tables.computed_hit_count() - hits;
+
+    op_stats& op = stats[cmd];
+    ++op.count;
+    op.total += seconds;
+    if (seconds > op.max) op.max = seconds;
+
+    os << setw(6) << line_no << setw(10) << cmd << setw(12) << seconds << setw(10);
+    if (result) os << node_count(result);
+    else os << "-";
+    os << setw(10) << lookups << setw(8);
+    if (lookups) os << setprecision(3) << 100.0 * hits / lookups << setprecision(6);
+    else os << "-";
+    os << endl << output.str();
+  }
+
+  double total = now() - start;
+
+  os << endl << setw(10) << "op" << setw(8) << "count" << setw(12) << "total (s)"
+     << setw(12) << "mean (s)" << setw(12) << "max (s)" << endl;
+  for (map<string, op_stats>::iterator it = stats.begin(); it != stats.end(); ++it)
+  {
+    const op_stats& op = it->second;
+    os << setw(10) << it->first << setw(8) << op.count << setw(12) << op.total
+       << setw(12) << op.total / op.count << setw(12) << op.max << endl;
+  }
+
+  unsigned long lookups = tables.computed_lookup_count();
+  os << endl
+     << "total time:        " << total << " s" << endl
+     << "unique table:      " << tables.unique_table_size() << " nodes" << endl
+     << "peak nodes:        " << tables.stats().peak_nodes << endl
+     << "garbage collected: " << tables.gc_released() << " nodes in " << tables.gc_runs()
+     << " runs" << endl
+     << "computed table:    " << lookups << " lookups, "
+     << (lookups ? 100.0 * tables.computed_hit_count() / lookups : 0.0) << "% hits" << endl
+     << "peak memory:       " << peak_memory_kb() << " kB" << endl;
+  if (failed) os << "failed statements: " << failed << endl;
+
+  return failed;
+}
+
+
+// writes the statements of a benchmark script.  intermediate results get
+// fresh names, t0, t1, ...
+struct script_writer
+{
+  script_writer(ostream& os_in) : os(os_in), next(0) {}
+
+  string fresh()
+  {
+    ostringstream name;
+    name << "t" << next++;
+    return name.str();
+  }
+
+  string apply(const string& op, const string& a, const string& b)
+  {
+    string name = fresh();
+    os << "apply " << name << " " << op << " " << a << " " << b << "\n";
+    return name;
+  }
+
+  void apply_to(const string& name, const string& op, const string& a, const string& b)
+  {
+    os << "apply " << name << " " << op << " " << a << " " << b << "\n";
+  }
+
+  void let(const string& name, const string& expr)
+  {
+    os << "let " << name << " " << expr << "\n";
+  }
+
+  void free(const string& name) { os << "free " << name << "\n"; }
+
+  // declares the vars, in this order
+  void inputs(const vector<string>& names)
+  {
+    os << "inputs";
+    for (size_t i = 0; i < names.size(); ++i) os << " " << names[i];
+    os << "\n";
+  }
+
+  // the sum bit of a full adder, and the carry out in carry
+  string full_adder(const string& a, const string& b, string& carry)
+  {
+    string half = apply("xor", a, b);
+    string sum = apply("xor", half, carry);
+    string both = apply("and", a, b);
+    string prop = apply("and", half, carry);
+    string carry_out = apply("or", both, prop);
+    free(half);
+    free(both);
+    free(prop);
+    if (carry != "0") free(carry);
+    carry = carry_out;
+    return sum;
+  }
+
+  ostream& os;
+  int next;
+};
+
+// the name of var prefix + i (+ "_" + j)
+static string var_name(const string& prefix, int i, int j = -1)
+{
+  ostringstream name;
+  name << prefix << i;
+  if (j >= 0) name << "_" << j;
+  return name.str();
+}
+
+// every row has a queen, and no two queens attack each other
+static void queens(script_writer& w, int n)
+{
+  vector<string> squares;
+  for (int r = 0; r < n; ++r)
+  {
+    for (int c = 0; c < n; ++c) squares.push_back(var_name("q", r, c));
+  }
+  w.inputs(squares);
+
+  w.let("board", "1");
+  for (int r = 0; r < n; ++r)
+  {
+    string row = var_name("q", r, 0);
+    for (int c = 1; c < n; ++c) row += " | " + var_name("q", r, c);
+    w.let("row", row);
+    w.apply_to("board", "and", "board", "row");
+
+    for (int c = 0; c < n; ++c)
+    {
+      // the squares below (r, c) that it attacks
+      for (int r2 = r + 1; r2 < n; ++r2)
+      {
+        int d = r2 - r;
+        int cols[3] = { c, c - d, c + d };
+        for (int k = 0; k < 3; ++k)
+        {
+          if (cols[k] < 0 || cols[k] >= n) continue;
+          w.let("pair", "!(" + var_name("q", r, c) + " & " + var_name("q", r2, cols[k]) + ")");
+          w.apply_to("board", "and", "board", "pair");
+        }
+      }
+      // the squares to its right in the same row
+      for (int c2 = c + 1; c2 < n; ++c2)
+      {
+        w.let("pair", "!(" + var_name("q", r, c) + " & " + var_name("q", r, c2) + ")");
+        w.apply_to("board", "and", "board", "pair");
+      }
+    }
+  }
+  w.free("row");
+  w.free("pair");
+}
+
+// a + b, with the vars interleaved: a0 b0 a1 b1 ...
+static void adder(script_writer& w, int n)
+{
+  vector<string> bits;
+  for (int i = 0; i < n; ++i)
+  {
+    bits.push_back(var_name("a", i));
+    bits.push_back(var_name("b", i));
+  }
+  w.inputs(bits);
+
+  string carry = "0";
+  for (int i = 0; i < n; ++i)
+  {
+    string sum = w.full_adder(var_name("a", i), var_name("b", i), carry);
+    w.apply_to(var_name("s", i), "or", sum, "0");
+    w.free(sum);
+  }
+  w.apply_to("cout", "or", carry, "0");
+}
+
+// a * b, adding the shifted partial products row by row.  the middle bits
+// of the product have exponentially large BDDs in any order
+static void multiplier(script_writer& w, int n)
+{
+  vector<string> bits;
+  for (int i = 0; i < n; ++i) bits.push_back(var_name("a", i));
+  for (int i = 0; i < n; ++i) bits.push_back(var_name("b", i));
+  w.inputs(bits);
+
+  // bits of the sum of the rows so far
+  vector<string> acc(2 * n, "0");
+  for (int i = 0; i < n; ++i)
+  {
+    string carry = "0";
+    for (int j = 0; j < n; ++j)
+    {
+      string pp = w.apply("and", var_name("a", j), var_name("b", i));
+      string sum = w.full_adder(acc[i + j], pp, carry);
+      w.free(pp);
+      if (acc[i + j] != "0") w.free(acc[i + j]);
+      acc[i + j] = sum;
+    }
+    acc[i + n] = carry;
+  }
+  for (int k = 0; k < 2 * n; ++k)
+  {
+    w.apply_to(var_name("p", k), "or", acc[k], "0");
+    if (acc[k] != "0") w.free(acc[k]);
+  }
+}
+
+// x0 ^ x1 ^ ... ^ xn-1, one var at a time
+static void parity(script_writer& w, int n)
+{
+  vector<string> bits;
+  for (int i = 0; i < n; ++i) bits.push_back(var_name("x", i));
+  w.inputs(bits);
+
+  w.let("parity", "0");
+  for (int i = 0; i < n; ++i)
+  {
+    w.apply_to("parity", "xor", "parity", var_name("x", i));
+  }
+}
+
+bool generate_benchmark(const string& kind, int n, ostream& os)
+{
+  void (*generate)(script_writer&, int);
+  if (kind == "queens") generate = queens;
+  else if (kind == "adder") generate = adder;
+  else if (kind == "multiplier") generate = multiplier;
+  else if (kind == "parity") generate = parity;
+  else return false;
+
+  script_writer w(os);
+  os << "# " << kind << " " << n << "\n";
+  generate(w, n);
+  return true;
+}
@@ -0,0 +1,89 @@
+#ifndef BDD_BATCH_H
+#define BDD_BATCH_H
+
+/*
+ * File bdd_batch.h
+ *
+ * The batch mode of project1: runs a script of BDD operations and reports
+ * how long each one took, and writes the scripts of synthetic benchmarks
+ */
+
+#include <iostream>
+#include <string>
+
+// A script has one statement per line.  Blank lines and lines starting
+// with # are skipped.  Results are kept under names; wherever an operand
+// A or B is expected, a name, 0, 1 or a var name may be used.  Vars are
+// declared by inputs (or come with load and netlist); a name that is
+// neither a result nor a var fails the statement.
+//
+//   inputs VAR...          adds the vars VAR..., in this order, after the
+//                          ones there are
+//   let NAME EXPR          NAME = the boolean expression EXPR (as in the
+//                          interactive mode).  names of results and vars
+//                          may be used in it
+//   apply NAME OP A B      NAME = A OP B, where OP is and, or or xor
+//   cofactor NAME A VAR V  NAME = A with VAR set to V (0 or 1)
+//   diff NAME A VAR        NAME = the boolean difference of A w.r.t. VAR
+//   exists NAME A C        NAME = A with the vars of C quantified out;
+//   forall NAME A C        C must be a conjunction of vars
+//   andex NAME A B C       NAME = exists(A B, C)
+//   support NAME A         NAME = the conjunction of the vars A depends on
+//   compose NAME A VAR B...
+//                          NAME = A with B substituted for VAR, for each
+//                          pair VAR B at once
+//   influence A            prints the influence of every var on A
+//   count A [VAR P]...     prints the number of assignments to all of the
+//                          vars that make A 1, and the probability that A
+//                          is 1 when each VAR is 1 with probability P and
+//                          the other vars with probability .5
+//   sort NAME A            NAME = sort_by_influence(A)
+//   reorder                sifts the vars
+//   autoreorder on|off     sifts the vars automatically as the BDDs
+//                          grow (off by default)
+//   compact                moves the nodes into level order in memory
+//   truthtable N           sets the threshold of the truth table path of
+//                          apply to N levels (0 turns it off, at most 12)
+//   isop NAME A [B]        NAME = an irredundant cover of A (or of a
+//                          function between A and B), as a ZDD
+//   zunion NAME P Q        NAME = P + Q, P Q, P - Q or the product of the
+//   zinter NAME P Q        ZDDs P and Q (0 and 1 are the empty family and
+//   zdiff NAME P Q         the family of the empty set).  see bdd_zdd.h
+//   zprod NAME P Q
+//   function NAME P        NAME = the BDD of the cover P
+//   cover P                prints the cover P as a sum of products
+//
+// A BDD, or a var, given where a ZDD P or Q is expected fails the
+// statement, and so does a ZDD given to isop.
+//
+//   print A                prints the BDD A
+//   save FILE A...         writes the BDDs A... to FILE (see bdd_io.h)
+//   dot FILE A...          writes the BDDs A... to FILE as a Graphviz
+//   blif FILE A...         graph or a BLIF netlist, or prints their
+//   table A...             nodes (see bdd_io.h)
+//   load FILE NAME...      reads the BDDs of FILE, one NAME for each
+//   netlist FILE [BUDGET]  builds the outputs of the BLIF netlist FILE,
+//                          each under its name, with at most BUDGET
+//                          nodes alive (see bdd_netlist.h)
+//   free NAME              drops the result NAME
+//
+// A NAME may be reused; the new result replaces the old one.
+//
+// Every statement is timed.  Its line of the report has the time, the
+// number of nodes in its result, and the computed table lookups it made
+// and how many of them hit.  The report ends with a summary per operation
+// and the totals: unique table size, peak number of nodes, garbage
+// collections, overall hit rate and peak memory use.
+//
+// returns the number of statements that failed
+int run_batch(std::istream& is, std::ostream& os);
+
+// writes the script of a synthetic benchmark of size n to os:
+//   queens      the n-queens constraints on an n x n board
+//   adder       the sum and carry out of an n bit ripple carry adder
+//   multiplier  the 2n bit product of an n x n bit array multiplier
+//   parity      the parity of n vars, as a chain of xors
+// returns false if kind is none of these
+bool generate_benchmark(const std::string& kind, int n, std::ostream& os);
+
+#endif
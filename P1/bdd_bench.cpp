@@ -0,0 +1,258 @@
+/*
+ * File bdd_bench.cpp
+ *
+ * A benchmark of the versions of ite (see project1.cpp): the iterative
+ * one, which keeps its pending calls on an explicit stack, the recursive
+ * one, and the parallel one.  Each workload is built once with every
+ * version, starting from empty tables, and the results are checked to be
+ * the same BDD.
+ *
+ * A second table compares apply on the nodes with the truth table path
+ * (see bdd_truth_table.h), on random formulas over a growing number of
+ * vars.
+ *
+ * usage: bdd_bench [scale [threads]]
+ * scale (default 1) multiplies the size of every workload.  the parallel
+ * version runs on threads threads (default 4)
+ */
+
+#include "bdd_node.h"
+#include "bdd_tables.h"
+#include "project1.h"
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <stdlib.h>
+#include <sys/time.h>
+
+using namespace std;
+
+// a version of ite
+typedef bdd_ptr (*ite_fn)(bdd_ptr f, bdd_ptr g, bdd_ptr h);
+
+// the boolean operations, in terms of a version of ite
+static bdd_ptr and_op(ite_fn ite_f, bdd_ptr f, bdd_ptr g) { return ite_f(f, g, bdd_node::zero()); }
+static bdd_ptr or_op(ite_fn ite_f, bdd_ptr f, bdd_ptr g) { return ite_f(f, bdd_node::one(), g); }
+static bdd_ptr xor_op(ite_fn ite_f, bdd_ptr f, bdd_ptr g) { return ite_f(f, g.complement(), g); }
+
+// the var named prefix + i
+static bdd_ptr var(const string& prefix, int i)
+{
+  ostringstream name;
+  name << prefix << i;
+  bdd_tables& tables = bdd_tables::getInstance();
+  return tables.var_bdd(tables.add_var(name.str()));
+}
+
+// the carry out of an n bit adder, with all of the a vars ordered before
+// the b vars.  the BDD grows exponentially with n in this order
+static bdd_ptr adder(ite_fn ite_f, int n)
+{
+  for (int i = 0; i < n; ++i) var("a", i);
+  for (int i = 0; i < n; ++i) var("b", i);
+
+  bdd_ptr carry = bdd_node::zero();
+  for (int i = 0; i < n; ++i)
+  {
+    bdd_ptr a = var("a", i);
+    bdd_ptr b = var("b", i);
+    carry = or_op(ite_f, and_op(ite_f, a, b), and_op(ite_f, carry, or_op(ite_f, a, b)));
+  }
+  return carry;
+}
+
+// the conjunction of the parity and the disjunction of n vars.  both are
+// built bottom up, which is cheap, and the final and goes n levels deep
+static bdd_ptr deep_chain(ite_fn ite_f, int n)
+{
+  for (int i = 0; i < n; ++i) var("x", i);
+
+  bdd_ptr parity = bdd_node::zero();
+  bdd_ptr any = bdd_node::zero();
+  for (int i = n - 1; i >= 0; --i)
+  {
+    bdd_ptr x = var("x", i);
+    parity = xor_op(ite_f, x, parity);
+    any = or_op(ite_f, x, any);
+  }
+  return and_op(ite_f, parity, any);
+}
+
+// a random formula of n ite's over 12 vars, the same one on every call
+static bdd_ptr random_ite(ite_fn ite_f, int n)
+{
+  srand(478);
+  vector<bdd_ptr> pool;
+  for (int i = 0; i < 12; ++i)
+  {
+    pool.push_back(var("r", i));
+  }
+  for (int i = 0; i < n; ++i)
+  {
+    bdd_ptr f = pool[rand() % pool.size()];
+    bdd_ptr g = pool[rand() % pool.size()];
+    bdd_ptr h = pool[rand() % pool.size()];
+    pool.push_back(ite_f(f, rand() % 2 ? g : g.complement(), h));
+  }
+  return pool.back();
+}
+
+typedef bdd_ptr (*workload_fn)(ite_fn ite_f, int n);
+
+// the nodes left over from the last run are dropped, so every run starts
+// from empty tables
+static void reset_tables()
+{
+  bdd_tables::getInstance().clear();
+}
+
+// wall clock time in seconds
+static double now()
+{
+  timeval tv;
+  gettimeofday(&tv, 0);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+// builds the workload with ite_f, returns the time it took in seconds
+static double run(workload_fn workload, ite_fn ite_f, int n, bdd_ptr& result)
+{
+  reset_tables();
+  double start = now();
+  result = workload(ite_f, n);
+  return now() - start;
+}
+
+// the number of threads for the parallel version
+static int num_threads = 4;
+
+// builds the workload again with the iterative ite while other is alive.
+// the BDDs are canonical, so the result must be the same edge
+static bool same_as_iterative(workload_fn workload, int n, const bdd_ptr& other)
+{
+  bdd_tables::getInstance().clear_computed_table();
+  return workload(ite, n) == other;
+}
+
+// every version is timed starting from empty tables
+static void bench(const string& name, workload_fn workload, int n, bool recursive)
+{
+  bdd_ptr result;
+  double iter_time = run(workload, ite, n, result);
+  unsigned int nodes = bdd_tables::getInstance().unique_table_size();
+
+  cout << setw(12) << name << setw(10) << n << setw(10) << nodes
+       << setw(12) << iter_time;
+
+  result = 0;
+  bool same = true;
+
+  if (recursive)
+  {
+    double rec_time = run(workload, ite_recursive, n, result);
+    same = same && same_as_iterative(workload, n, result);
+    result = 0;
+    cout << setw(12) << rec_time;
+  }
+  else
+  {
+    // too deep for the call stack
+    cout << setw(12) << "-";
+  }
+
+  set_num_threads(num_threads);
+  double par_time = run(workload, ite, n, result);
+  set_num_threads(1);
+  same = same && same_as_iterative(workload, n, result);
+
+  cout << setw(12) << par_time << setw(8) << (same ? "yes" : "NO") << endl;
+}
+
+// a random formula of n applies over k vars, the same one on every call
+static bdd_ptr random_apply(int k, int n)
+{
+  static const int codes[] = { OP_AND, OP_OR, OP_XOR };
+
+  srand(478);
+  vector<bdd_ptr> pool;
+  for (int i = 0; i < k; ++i)
+  {
+    pool.push_back(var("t", i));
+  }
+  for (int i = 0; i < n; ++i)
+  {
+    bdd_ptr f = pool[rand() % pool.size()];
+    bdd_ptr g = pool[rand() % pool.size()];
+    pool.push_back(apply(f, rand() % 2 ? g : g.complement(), codes[rand() % 3]));
+  }
+  return pool.back();
+}
+
+// builds random_apply with the truth table threshold at threshold, returns
+// the time it took in seconds
+static double run_apply(int k, int n, int threshold, bdd_ptr& result)
+{
+  reset_tables();
+  bdd_tables& tables = bdd_tables::getInstance();
+  int saved = tables.truth_table_threshold();
+  tables.set_truth_table_threshold(threshold);
+  double start = now();
+  result = random_apply(k, n);
+  double time = now() - start;
+  tables.set_truth_table_threshold(saved);
+  return time;
+}
+
+// random_apply over k vars on the nodes and on truth tables
+static void bench_apply(int k, int n)
+{
+  bdd_ptr result;
+  double node_time = run_apply(k, n, 0, result);
+  unsigned int nodes = bdd_tables::getInstance().unique_table_size();
+  result = 0;
+
+  double table_time = run_apply(k, n, k, result);
+  bdd_tables& tables = bdd_tables::getInstance();
+  int saved = tables.truth_table_threshold();
+  tables.set_truth_table_threshold(0);
+  tables.clear_computed_table();
+  bool same = (random_apply(k, n) == result);
+  tables.set_truth_table_threshold(saved);
+  result = 0;
+
+  cout << setw(12) << k << setw(10) << n << setw(10) << nodes
+       << setw(12) << node_time << setw(12) << table_time
+       << setw(8) << (same ? "yes" : "NO") << endl;
+}
+
+int main(int argc, char *argv[])
+{
+  int scale = (argc > 1) ? atoi(argv[1]) : 1;
+  if (scale < 1) scale = 1;
+  if (argc > 2) num_threads = atoi(argv[2]);
+  if (num_threads < 1) num_threads = 1;
+
+  // the order is part of the workload
+  bdd_tables::getInstance().set_reordering(false);
+
+  cout << setw(12) << "workload" << setw(10) << "size" << setw(10) << "nodes"
+       << setw(12) << "iter (s)" << setw(12) << "rec (s)" << setw(12) << "par (s)"
+       << setw(8) << "same" << endl;
+
+  bench("adder", adder, 12 + scale, true);
+  bench("random", random_ite, 2000 * scale, true);
+  bench("chain", deep_chain, 2000 * scale, true);
+  bench("deep chain", deep_chain, 50000 * scale, false);
+
+  cout << endl << setw(12) << "vars" << setw(10) << "size" << setw(10) << "nodes"
+       << setw(12) << "node (s)" << setw(12) << "table (s)" << setw(8) << "same" << endl;
+
+  for (int k = 6; k <= 16; k += 2)
+  {
+    bench_apply(k, 2000 * scale);
+  }
+
+  return 0;
+}
@@ -0,0 +1,219 @@
+/*
+ * File bdd_compiler.cpp
+ *
+ * Contains the implementation of compile_expr, declared in bdd_compiler.h
+ */
+
+#include "bdd_compiler.h"
+#include "bdd_tables.h"
+#include "project1.h"
+
+#include <cctype>
+#include <vector>
+
+using namespace std;
+
+typedef BoolExprParser::Error expr_error;
+
+// combines the operands of a chain of ands or ors as they are read, as a
+// balanced tree.  like a binary counter, two partial results are combined
+// when they cover the same number of operands, so at most log2 of the
+// number of operands are pending at any time.  once the chain is the
+// constant that absorbs the operation (0 for and, 1 for or), the rest of
+// its operands are ignored
+class balanced_chain
+{
+public:
+  explicit balanced_chain(int code_in) :
+    code(code_in), absorbing(code_in == OP_AND ? bdd_node::zero() : bdd_node::one()), absorbed(false)
+  {}
+
+  void add(const bdd_ptr& f)
+  {
+    if (absorbed) return;
+
+    bdd_ptr g = f;
+    unsigned long size = 1;
+    while (g != absorbing && !partial.empty() && partial.back().second == size)
+    {
+      g = apply(partial.back().first, g, code);
+      partial.pop_back();
+      size *= 2;
+    }
+
+    if (g == absorbing)
+    {
+      absorbed = true;
+      partial.clear();
+      return;
+    }
+    partial.push_back(make_pair(g, size));
+  }
+
+  // the chain of the operands added so far, of which there is at least one
+  bdd_ptr result()
+  {
+    if (absorbed) return absorbing;
+
+    bdd_ptr g = partial.back().first;
+    for (int i = (int)partial.size() - 2; i >= 0; --i)
+    {
+      g = apply(partial[i].first, g, code);
+    }
+    return g;
+  }
+
+private:
+  int code;
+  bdd_ptr absorbing;
+  bool absorbed;
+
+  // partial results, and how many operands each one covers, in decreasing
+  // order of the latter
+  vector<pair<bdd_ptr, unsigned long> > partial;
+};
+
+// a recursive descent compiler, with a function for each rule of the
+// grammar:
+//
+//   expr   := term { | term }
+//   term   := factor { & factor }
+//   factor := { ! } atom
+//   atom   := ( expr ) | name
+class expr_compiler
+{
+public:
+  expr_compiler(const string& expr_in, const map<string, bdd_ptr>* names_in, bool add_vars_in) :
+    text(expr_in.data()), length(expr_in.size()), pos(0), names(names_in),
+    add_vars(add_vars_in), tables(bdd_tables::getInstance())
+  {}
+
+  bdd_ptr compile()
+  {
+    bdd_ptr f = expr();
+    skip_spaces();
+    if (pos != length) throw expr_error(pos, expr_error::GARBAGE_AT_END);
+    return f;
+  }
+
+private:
+  bdd_ptr expr()
+  {
+    balanced_chain chain(OP_OR);
+    chain.add(term());
+    while (seen('|'))
+    {
+      ++pos;
+      chain.add(term());
+    }
+    return chain.result();
+  }
+
+  bdd_ptr term()
+  {
+    balanced_chain chain(OP_AND);
+    chain.add(factor());
+    while (seen('&'))
+    {
+      ++pos;
+      chain.add(factor());
+    }
+    return chain.result();
+  }
+
+  bdd_ptr factor()
+  {
+    bool negated = false;
+    while (seen('!'))
+    {
+      ++pos;
+      negated = !negated;
+    }
+
+    // negation just flips the complement bit of the edge
+    bdd_ptr f = atom();
+    return negated ? f.complement() : f;
+  }
+
+  bdd_ptr atom()
+  {
+    skip_spaces();
+    size_t start = pos;
+    if (!seen('(')) return name();
+
+    ++pos;
+    bdd_ptr f = expr();
+    if (!seen(')')) throw expr_error(start, expr_error::RUNAWAY_PARENTHESIS);
+    ++pos;
+    return f;
+  }
+
+  bdd_ptr name()
+  {
+    skip_spaces();
+    if (pos == length) throw expr_error(pos, expr_error::STRING_EXPECTED);
+
+    size_t start = pos;
+    if (text[pos] == '"')
+    {
+      start = ++pos;
+      while (pos < length && text[pos] != '"') ++pos;
+      if (pos == length) throw expr_error(start - 1, expr_error::RUNAWAY_DOUBLE_QUOTES);
+      if (pos == start)  throw expr_error(start - 1, expr_error::EMPTY_QUOTED_STRING);
+      buf.assign(text + start, pos - start);
+      ++pos; // the closing quotes
+    }
+    else
+    {
+      while (pos < length && (isalnum((unsigned char)text[pos]) || text[pos] == '_')) ++pos;
+      if (pos == start) throw expr_error(start, expr_error::STRING_EXPECTED);
+      buf.assign(text + start, pos - start);
+    }
+
+    if (names)
+    {
+      map<string, bdd_ptr>::const_iterator it = names->find(buf);
+      if (it != names->end()) return it->second;
+    }
+    if (buf == "0") return bdd_node::zero();
+    if (buf == "1") return bdd_node::one();
+    if (add_vars) return tables.var_bdd(tables.add_var(buf));
+
+    int var = tables.find_var(buf);
+    if (var < 0) throw unknown_name_error(start, buf);
+    return tables.var_bdd(var);
+  }
+
+  void skip_spaces()
+  {
+    while (pos < length && isspace((unsigned char)text[pos])) ++pos;
+  }
+
+  // whether or not the next token is c
+  bool seen(char c)
+  {
+    skip_spaces();
+    return pos < length && text[pos] == c;
+  }
+
+  const char* text;
+  size_t length;
+  size_t pos;
+  const map<string, bdd_ptr>* names;
+  bool add_vars;
+  bdd_tables& tables;
+
+  // the name being read.  reused, so names don't allocate once it is
+  // long enough
+  string buf;
+};
+
+bdd_ptr compile_expr(const string& expr)
+{
+  return expr_compiler(expr, 0, true).compile();
+}
+
+bdd_ptr compile_expr(const string& expr, const map<string, bdd_ptr>& names, bool add_vars)
+{
+  return expr_compiler(expr, &names, add_vars).compile();
+}
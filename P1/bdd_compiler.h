@@ -0,0 +1,48 @@
+#ifndef BDD_COMPILER_H
+#define BDD_COMPILER_H
+
+/*
+ * File bdd_compiler.h
+ *
+ * Compiles boolean expressions straight into BDDs
+ */
+
+#include <map>
+#include <string>
+#include "bdd_node.h"
+#include "Bool_expr_parser.h"
+
+// compile_expr turns a boolean expression into a BDD in one pass over its
+// text, applying the operators as it reads them, without building the
+// syntax tree of BoolExprParser first.  The syntax is the same: | (or), &
+// (and), ! (not) and parentheses, with & binding tighter than |, and
+// names made of letters, digits and _, or any text in double quotes.  0
+// and 1 are the constants, names in names (if given) stand for the BDDs
+// they are mapped to, and any other name is the var with that name, added
+// if it doesn't exist yet.
+//
+// The operands of a chain of ands or ors (such as the products of a sum of
+// products) are combined as a balanced tree of applies rather than one at
+// a time, so the intermediate BDDs stay small, and a chain that becomes
+// constant isn't combined any further.  Only parentheses nest on the stack.
+//
+// throws BoolExprParser::Error, with the column and the same code as
+// BoolExprParser::parse, if expr is malformed.  If add_vars is false, a
+// name that is neither in names, a constant nor an existing var throws
+// unknown_name_error instead of adding a var
+bdd_ptr compile_expr(const std::string& expr);
+bdd_ptr compile_expr(const std::string& expr, const std::map<std::string, bdd_ptr>& names,
+                     bool add_vars = true);
+
+// a name that doesn't stand for anything, at index in the text it was read
+// from
+struct unknown_name_error
+{
+  unknown_name_error(size_t index_in, const std::string& name_in) :
+    index(index_in), name(name_in) {}
+
+  size_t index;
+  std::string name;
+};
+
+#endif
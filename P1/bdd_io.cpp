@@ -0,0 +1,479 @@
+/*
+ * File bdd_io.cpp
+ *
+ * Contains the implementation of the functions declared in bdd_io.h, and
+ * the varint encoding of the files
+ */
+
+#include "bdd_io.h"
+#include "bdd_tables.h"
+#include "project1.h"
+#include "bdd_zdd.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+static const char magic[] = "P1BDD";
+static const size_t magic_size = sizeof(magic) - 1;
+static const unsigned char version = 2;
+
+static void put_varint(string& buf, unsigned long value)
+{
+  while (value >= 0x80)
+  {
+    buf += (char)((value & 0x7f) | 0x80);
+    value >>= 7;
+  }
+  buf += (char)value;
+}
+
+// reads the numbers of a file.  once a read fails, ok is false and every
+// later read returns 0
+struct varint_reader
+{
+  varint_reader(const char* data, size_t size) :
+    p((const unsigned char*)data), end((const unsigned char*)data + size), ok(true)
+  {}
+
+  unsigned long get()
+  {
+    unsigned long value = 0;
+    for (unsigned int shift = 0; ok && shift < 64; shift += 7)
+    {
+      if (p == end) break;
+      unsigned char byte = *p++;
+      value |= (unsigned long)(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) return value;
+    }
+    ok = false;
+    return 0;
+  }
+
+  // a count of things that take at least min_bytes each, which can't be
+  // more than what is left
+  unsigned long get_count(size_t min_bytes)
+  {
+    unsigned long count = get();
+    if (count > remaining() / min_bytes) ok = false;
+    return ok ? count : 0;
+  }
+
+  size_t remaining() const { return end - p; }
+
+  const unsigned char* p;
+  const unsigned char* end;
+  bool ok;
+};
+
+// numbers the nodes of roots children first, depth first from each root
+// in turn.  the terminal is node 0, and node i is nodes[i - 1]
+static void number_nodes(const vector<bdd_ptr>& roots, vector<bdd_node*>& nodes,
+                         map<bdd_node*, unsigned long>& index)
+{
+  index[bdd_node::one().node()] = 0;
+
+  // a node, and whether or not its children have been numbered
+  vector<pair<bdd_node*, bool> > stack;
+  for (size_t r = 0; r < roots.size(); ++r)
+  {
+    stack.push_back(make_pair(roots[r].node(), false));
+    while (!stack.empty())
+    {
+      bdd_node* n = stack.back().first;
+      bool expanded = stack.back().second;
+      stack.pop_back();
+      if (index.count(n)) continue;
+
+      if (expanded)
+      {
+        nodes.push_back(n);
+        index[n] = nodes.size();
+        continue;
+      }
+      stack.push_back(make_pair(n, true));
+      stack.push_back(make_pair(n->pos_cf.node(), false));
+      stack.push_back(make_pair(n->neg_cf.node(), false));
+    }
+  }
+}
+
+// the vars of nodes, top level first
+static vector<int> node_vars(const bdd_tables& tables, const vector<bdd_node*>& nodes)
+{
+  vector<int> levels;
+  for (size_t i = 0; i < nodes.size(); ++i)
+  {
+    levels.push_back(tables.level(nodes[i]->var));
+  }
+  sort(levels.begin(), levels.end());
+  levels.erase(unique(levels.begin(), levels.end()), levels.end());
+
+  vector<int> vars;
+  for (size_t i = 0; i < levels.size(); ++i)
+  {
+    vars.push_back(tables.var_at_level(levels[i]));
+  }
+  return vars;
+}
+
+void write_bdds(ostream& os, const vector<bdd_ptr>& roots)
+{
+  bdd_tables& tables = bdd_tables::getInstance();
+
+  map<bdd_node*, unsigned long> index;
+  vector<bdd_node*> nodes;
+  number_nodes(roots, nodes, index);
+
+  vector<int> vars = node_vars(tables, nodes);
+  map<int, unsigned long> var_index;
+  string buf(magic, magic_size);
+  buf += (char)version;
+  put_varint(buf, vars.size());
+  for (size_t i = 0; i < vars.size(); ++i)
+  {
+    int var = vars[i];
+    var_index[var] = i;
+    put_varint(buf, 2 * tables.var_name(var).size() + (tables.is_zdd_var(var) ? 1 : 0));
+    buf += tables.var_name(var);
+  }
+
+  put_varint(buf, nodes.size());
+  for (size_t i = 0; i < nodes.size(); ++i)
+  {
+    bdd_node* n = nodes[i];
+    unsigned long self = i + 1;
+    put_varint(buf, var_index[n->var]);
+    put_varint(buf, ((self - index[n->neg_cf.node()]) << 1) | (n->neg_cf.is_complemented() ? 1 : 0));
+    put_varint(buf, ((self - index[n->pos_cf.node()]) << 1) | (n->pos_cf.is_complemented() ? 1 : 0));
+  }
+
+  put_varint(buf, roots.size());
+  for (size_t r = 0; r < roots.size(); ++r)
+  {
+    put_varint(buf, (index[roots[r].node()] << 1) | (roots[r].is_complemented() ? 1 : 0));
+  }
+
+  os.write(buf.data(), buf.size());
+}
+
+bool save_bdds(const string& path, const vector<bdd_ptr>& roots, string& error)
+{
+  ofstream os(path.c_str(), ios::out | ios::binary | ios::trunc);
+  if (os)
+  {
+    write_bdds(os, roots);
+    os.close();
+  }
+  if (!os)
+  {
+    error = "can't write " + path;
+    return false;
+  }
+  return true;
+}
+
+// a node as it is in the file
+struct saved_node
+{
+  unsigned long var;
+  unsigned long neg; // index of the child and complement bit, as a root
+  unsigned long pos;
+};
+
+bool read_bdds(const char* data, size_t size, vector<bdd_ptr>& roots, string& error)
+{
+  if (size < magic_size + 1 || memcmp(data, magic, magic_size) != 0)
+  {
+    error = "not a BDD file";
+    return false;
+  }
+  unsigned char file_version = data[magic_size];
+  if (file_version != 1 && file_version != version)
+  {
+    error = "unsupported BDD file version";
+    return false;
+  }
+  varint_reader in(data + magic_size + 1, size - magic_size - 1);
+
+  // the whole file is checked before anything is added to the tables
+  vector<string> names(in.get_count(1));
+  vector<bool> zdd(names.size(), false);
+  for (size_t i = 0; i < names.size() && in.ok; ++i)
+  {
+    unsigned long length = in.get();
+    if (file_version > 1)
+    {
+      zdd[i] = (length & 1) != 0;
+      length >>= 1;
+    }
+    if (length > in.remaining()) in.ok = false;
+    if (!in.ok) break;
+    names[i].assign((const char*)in.p, length);
+    in.p += length;
+  }
+
+  vector<saved_node> nodes(in.get_count(3));
+  for (unsigned long i = 0; i < nodes.size() && in.ok; ++i)
+  {
+    unsigned long self = i + 1;
+    saved_node& n = nodes[i];
+    n.var = in.get();
+    unsigned long neg = in.get();
+    unsigned long pos = in.get();
+    if (n.var >= names.size() || (neg >> 1) == 0 || (neg >> 1) > self ||
+        (pos >> 1) == 0 || (pos >> 1) > self)
+    {
+      in.ok = false;
+      break;
+    }
+    n.neg = ((self - (neg >> 1)) << 1) | (neg & 1);
+    n.pos = ((self - (pos >> 1)) << 1) | (pos & 1);
+
+    // the children must be on vars below the node's, and of the same kind:
+    // ZDDs under a ZDD node, whose only complemented edge is the one to 0,
+    // and BDDs under a BDD node
+    unsigned long children[2] = { n.neg, n.pos };
+    for (int c = 0; c < 2; ++c)
+    {
+      unsigned long child = children[c] >> 1;
+      if (child == 0) continue;
+      unsigned long child_var = nodes[child - 1].var;
+      if (child_var <= n.var || zdd[child_var] != zdd[n.var] || (zdd[n.var] && (children[c] & 1)))
+      {
+        in.ok = false;
+      }
+    }
+  }
+
+  vector<unsigned long> saved_roots(in.get_count(1));
+  for (size_t r = 0; r < saved_roots.size() && in.ok; ++r)
+  {
+    saved_roots[r] = in.get();
+    unsigned long root = saved_roots[r] >> 1;
+    if (root > nodes.size() || (root && (saved_roots[r] & 1) && zdd[nodes[root - 1].var]))
+    {
+      in.ok = false;
+    }
+  }
+
+  if (!in.ok || in.remaining() != 0)
+  {
+    error = "corrupt BDD file";
+    return false;
+  }
+
+  bdd_op_scope scope;
+  bdd_tables& tables = bdd_tables::getInstance();
+
+  // the vars of the file, and whether or not they are in the same order
+  // here
+  for (size_t i = 0; i < names.size(); ++i)
+  {
+    int var = tables.find_var(names[i]);
+    if (var >= 0 && tables.is_zdd_var(var) != zdd[i])
+    {
+      error = "var " + names[i] + " is a " + (zdd[i] ? "BDD" : "ZDD") + " var here";
+      return false;
+    }
+  }
+
+  vector<int> vars(names.size());
+  bool same_order = true;
+  for (size_t i = 0; i < names.size(); ++i)
+  {
+    vars[i] = zdd[i] ? tables.add_zdd_var(names[i]) : tables.add_var(names[i]);
+    if (i > 0 && tables.level(vars[i]) <= tables.level(vars[i - 1])) same_order = false;
+  }
+
+  vector<bdd_ptr> built(nodes.size() + 1);
+  built[0] = bdd_node::one();
+  for (size_t i = 0; i < nodes.size(); ++i)
+  {
+    const saved_node& n = nodes[i];
+    bdd_ptr neg = built[n.neg >> 1];
+    bdd_ptr pos = built[n.pos >> 1];
+    if (n.neg & 1) neg = neg.complement();
+    if (n.pos & 1) pos = pos.complement();
+
+    int var = vars[n.var];
+    if (zdd[n.var])
+    {
+      built[i + 1] = same_order ? tables.get_zdd_node(var, neg, pos) : zdd_union(neg, zdd_change(pos, var));
+    }
+    else
+    {
+      built[i + 1] = same_order ? tables.get_node(var, neg, pos) : ite(tables.var_bdd(var), pos, neg);
+    }
+  }
+
+  for (size_t r = 0; r < saved_roots.size(); ++r)
+  {
+    bdd_ptr root = built[saved_roots[r] >> 1];
+    roots.push_back((saved_roots[r] & 1) ? root.complement() : root);
+  }
+  return true;
+}
+
+bool load_bdds(const string& path, vector<bdd_ptr>& roots, string& error)
+{
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    error = path + ": " + strerror(errno);
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0)
+  {
+    error = path + ": " + strerror(errno);
+    close(fd);
+    return false;
+  }
+  if (st.st_size == 0)
+  {
+    close(fd);
+    return read_bdds("", 0, roots, error);
+  }
+
+  void* data = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+  {
+    error = path + ": " + strerror(errno);
+    return false;
+  }
+  madvise(data, st.st_size, MADV_SEQUENTIAL);
+
+  bool ok = read_bdds((const char*)data, st.st_size, roots, error);
+  munmap(data, st.st_size);
+  return ok;
+}
+
+// the name of root r
+static string root_name(const vector<string>& names, size_t r)
+{
+  if (r < names.size()) return names[r];
+  ostringstream name;
+  name << "f" << r;
+  return name.str();
+}
+
+// s in double quotes, as DOT wants names
+static string dot_quoted(const string& s)
+{
+  string quoted = "\"";
+  for (size_t i = 0; i < s.size(); ++i)
+  {
+    if (s[i] == '"' || s[i] == '\\') quoted += '\\';
+    quoted += s[i];
+  }
+  return quoted + "\"";
+}
+
+void write_dot(ostream& os, const vector<bdd_ptr>& roots, const vector<string>& names)
+{
+  bdd_tables& tables = bdd_tables::getInstance();
+  map<bdd_node*, unsigned long> index;
+  vector<bdd_node*> nodes;
+  number_nodes(roots, nodes, index);
+
+  os << "digraph bdd {\n";
+  os << "  n0 [shape=box, label=\"1\"];\n";
+
+  // level -> its nodes, so each level is drawn on a row of its own
+  map<int, vector<unsigned long> > rows;
+  for (size_t i = 0; i < nodes.size(); ++i)
+  {
+    os << "  n" << i + 1 << " [label=" << dot_quoted(tables.var_name(nodes[i]->var)) << "];\n";
+    rows[tables.level(nodes[i]->var)].push_back(i + 1);
+  }
+  for (map<int, vector<unsigned long> >::iterator it = rows.begin(); it != rows.end(); ++it)
+  {
+    os << "  { rank=same;";
+    for (size_t i = 0; i < it->second.size(); ++i) os << " n" << it->second[i] << ";";
+    os << " }\n";
+  }
+
+  for (size_t i = 0; i < nodes.size(); ++i)
+  {
+    bdd_node* n = nodes[i];
+    os << "  n" << i + 1 << " -> n" << index[n->neg_cf.node()] << " [style=dashed"
+       << (n->neg_cf.is_complemented() ? ", arrowhead=odot" : "") << "];\n";
+    os << "  n" << i + 1 << " -> n" << index[n->pos_cf.node()]
+       << (n->pos_cf.is_complemented() ? " [arrowhead=odot]" : "") << ";\n";
+  }
+
+  for (size_t r = 0; r < roots.size(); ++r)
+  {
+    os << "  r" << r << " [shape=plaintext, label=" << dot_quoted(root_name(names, r)) << "];\n";
+    os << "  r" << r << " -> n" << index[roots[r].node()]
+       << (roots[r].is_complemented() ? " [arrowhead=odot]" : "") << ";\n";
+  }
+  os << "}\n";
+}
+
+void write_blif(ostream& os, const vector<bdd_ptr>& roots, const vector<string>& names)
+{
+  bdd_tables& tables = bdd_tables::getInstance();
+  map<bdd_node*, unsigned long> index;
+  vector<bdd_node*> nodes;
+  number_nodes(roots, nodes, index);
+
+  os << ".model bdd\n.inputs";
+  vector<int> vars = node_vars(tables, nodes);
+  for (size_t i = 0; i < vars.size(); ++i) os << " " << tables.var_name(vars[i]);
+  os << "\n.outputs";
+  for (size_t r = 0; r < roots.size(); ++r) os << " " << root_name(names, r);
+  os << "\n.names _n0\n1\n";
+
+  // node i is the mux var ? then : else, with the complemented inputs
+  // inverted in its rows
+  for (size_t i = 0; i < nodes.size(); ++i)
+  {
+    bdd_node* n = nodes[i];
+    os << ".names " << tables.var_name(n->var) << " _n" << index[n->pos_cf.node()]
+       << " _n" << index[n->neg_cf.node()] << " _n" << i + 1 << "\n";
+    os << "1" << (n->pos_cf.is_complemented() ? "0" : "1") << "- 1\n";
+    os << "0-" << (n->neg_cf.is_complemented() ? "0" : "1") << " 1\n";
+  }
+
+  for (size_t r = 0; r < roots.size(); ++r)
+  {
+    os << ".names _n" << index[roots[r].node()] << " " << root_name(names, r) << "\n"
+       << (roots[r].is_complemented() ? "0" : "1") << " 1\n";
+  }
+  os << ".end\n";
+}
+
+void write_node_table(ostream& os, const vector<bdd_ptr>& roots, const vector<string>& names)
+{
+  bdd_tables& tables = bdd_tables::getInstance();
+  map<bdd_node*, unsigned long> index;
+  vector<bdd_node*> nodes;
+  number_nodes(roots, nodes, index);
+
+  os << "# " << nodes.size() << " nodes: number, var, else and then edges\n";
+  for (size_t i = 0; i < nodes.size(); ++i)
+  {
+    bdd_node* n = nodes[i];
+    os << i + 1 << " " << tables.var_name(n->var)
+       << " " << (n->neg_cf.is_complemented() ? "!" : "") << index[n->neg_cf.node()]
+       << " " << (n->pos_cf.is_complemented() ? "!" : "") << index[n->pos_cf.node()] << "\n";
+  }
+  for (size_t r = 0; r < roots.size(); ++r)
+  {
+    os << root_name(names, r) << " = " << (roots[r].is_complemented() ? "!" : "")
+       << index[roots[r].node()] << "\n";
+  }
+}
@@ -0,0 +1,83 @@
+#ifndef BDD_IO_H
+#define BDD_IO_H
+
+/*
+ * File bdd_io.h
+ *
+ * Saving BDDs to a compact binary file, and loading them back, and text
+ * exports of BDDs for other tools
+ */
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "bdd_node.h"
+
+// A file holds a list of BDDs (the roots) and the nodes they share, each
+// node once.  All numbers are unsigned varints: 7 bits per byte, lowest
+// first, with the high bit set on every byte but the last.
+//
+//   "P1BDD" and a version byte (2)
+//   the number of vars V, then V times: 2 times the length of its name,
+//     plus 1 for a ZDD var (see bdd_zdd.h), and the name.  these are the
+//     vars the roots depend on, top level first
+//   the number of nodes N, then N times, children first: the var (its index
+//     in the list above), the else edge and the then edge
+//   the number of roots R, then R times: the edge to the root
+//
+// Node i (1 to N, in the order they are written) refers to node j below it
+// with the edge 2 (i - j) + c, where c is 1 for a complemented edge and
+// node 0 is the terminal.  Since the nodes are written in depth first
+// order, children are mostly close to their parents, and the edges fit in
+// a byte or two.  A root is the edge 2 j + c.  Version 1 files, without
+// ZDD vars, have just the length of the names.  A ZDD node only has ZDD
+// nodes as children, and no complemented edges but those to 0, and a BDD
+// node only has BDD nodes; nor is a root a complemented edge to a ZDD
+// node.
+//
+// The BDDs are loaded into the current manager (see bdd_manager.h).  Vars
+// are matched by name, and the ones it doesn't have yet are added at the
+// bottom.  If the vars are in the same order there as in the file, the
+// nodes are added to the unique table one by one, in a single pass over
+// the file; otherwise each node is rebuilt with ite (or the ZDD operations
+// for ZDD nodes), which reorders it.
+
+// writes roots to os
+void write_bdds(std::ostream& os, const std::vector<bdd_ptr>& roots);
+
+// writes roots to the file at path.  returns false and sets error if the
+// file can't be written
+bool save_bdds(const std::string& path, const std::vector<bdd_ptr>& roots, std::string& error);
+
+// reads the BDDs in the size bytes at data, and appends them to roots.
+// returns false and sets error if data isn't a valid file, in which case
+// roots is left as it was
+bool read_bdds(const char* data, size_t size, std::vector<bdd_ptr>& roots, std::string& error);
+
+// maps the file at path into memory and reads it with read_bdds
+bool load_bdds(const std::string& path, std::vector<bdd_ptr>& roots, std::string& error);
+
+// The text exports visit every node of the roots once, so unlike print
+// (see bdd_node.h), which repeats a shared node on every path to it, their
+// size is linear in the number of nodes.  Nodes are numbered as in the
+// binary files, with the terminal 1 as node 0, and root r is named
+// names[r] (or fr if names is shorter).
+
+// writes a Graphviz graph: a node per BDD node, one row per level, dashed
+// else edges and complemented edges ending in a circle
+void write_dot(std::ostream& os, const std::vector<bdd_ptr>& roots,
+               const std::vector<std::string>& names);
+
+// writes a BLIF netlist with a multiplexer per node, named _ni for node i,
+// whose inputs are the vars of the roots and whose outputs are the roots
+void write_blif(std::ostream& os, const std::vector<bdd_ptr>& roots,
+                const std::vector<std::string>& names);
+
+// writes a line "i var else then" per node, where an edge is the number
+// of its node, after a ! if it is complemented, and a line "name = edge"
+// per root
+void write_node_table(std::ostream& os, const std::vector<bdd_ptr>& roots,
+                      const std::vector<std::string>& names);
+
+#endif
@@ -0,0 +1,276 @@
+/*
+ * File bdd_manager.cpp
+ *
+ * Contains the implementation of the class methods of bdd_manager,
+ * defined in bdd_manager.h
+ */
+
+#include "bdd_manager.h"
+#include "project1.h"
+#include "bdd_io.h"
+#include "bdd_zdd.h"
+
+using namespace std;
+
+bdd_manager::bdd_manager()
+{
+}
+
+// the store's chunks go away after the tables, in one go
+bdd_manager::~bdd_manager()
+{
+  if (bdd_node::current_store == this)
+  {
+    bdd_node::current_store = 0;
+  }
+}
+
+// Meyers Singleton Accessor
+bdd_manager& bdd_manager::default_manager()
+{
+  static bdd_manager the_manager;
+  return the_manager;
+}
+
+bdd_node_store& bdd_node::default_store()
+{
+  return bdd_manager::default_manager();
+}
+
+bdd_manager* bdd_manager::make_current(bdd_manager* manager)
+{
+  bdd_manager* previous = &current();
+  bdd_node::current_store = manager;
+  return previous;
+}
+
+bdd_ptr bdd_manager::var(const string& name)
+{
+  bdd_manager_scope scope(*this);
+  return the_tables.var_bdd(the_tables.add_var(name));
+}
+
+bdd_ptr bdd_manager::ite(const bdd_ptr& f, const bdd_ptr& g, const bdd_ptr& h)
+{
+  bdd_manager_scope scope(*this);
+  return ::ite(f, g, h);
+}
+
+bdd_ptr bdd_manager::apply(const bdd_ptr& bdd1, const bdd_ptr& bdd2, const string& o)
+{
+  bdd_manager_scope scope(*this);
+  return ::apply(bdd1, bdd2, o);
+}
+
+bdd_ptr bdd_manager::apply(const bdd_ptr& bdd1, const bdd_ptr& bdd2, operation &op)
+{
+  bdd_manager_scope scope(*this);
+  return ::apply(bdd1, bdd2, op);
+}
+
+bdd_ptr bdd_manager::apply(const bdd_ptr& bdd1, const bdd_ptr& bdd2, int code)
+{
+  bdd_manager_scope scope(*this);
+  return ::apply(bdd1, bdd2, code);
+}
+
+bdd_ptr bdd_manager::restrict(const bdd_ptr& f, int var, bool value)
+{
+  bdd_manager_scope scope(*this);
+  return ::restrict(f, var, value);
+}
+
+bdd_ptr bdd_manager::cofactor(const bdd_ptr& f, const bdd_ptr& cube)
+{
+  bdd_manager_scope scope(*this);
+  return ::cofactor(f, cube);
+}
+
+bdd_ptr bdd_manager::negative_cofactor(const bdd_ptr& np, int var)
+{
+  bdd_manager_scope scope(*this);
+  return ::negative_cofactor(np, var);
+}
+
+bdd_ptr bdd_manager::positive_cofactor(const bdd_ptr& np, int var)
+{
+  bdd_manager_scope scope(*this);
+  return ::positive_cofactor(np, var);
+}
+
+bdd_ptr bdd_manager::boolean_difference(const bdd_ptr& np, int var)
+{
+  bdd_manager_scope scope(*this);
+  return ::boolean_difference(np, var);
+}
+
+bdd_ptr bdd_manager::exists(const bdd_ptr& f, const bdd_ptr& cube)
+{
+  bdd_manager_scope scope(*this);
+  return ::exists(f, cube);
+}
+
+bdd_ptr bdd_manager::forall(const bdd_ptr& f, const bdd_ptr& cube)
+{
+  bdd_manager_scope scope(*this);
+  return ::forall(f, cube);
+}
+
+bdd_ptr bdd_manager::and_exists(const bdd_ptr& f, const bdd_ptr& g, const bdd_ptr& cube)
+{
+  bdd_manager_scope scope(*this);
+  return ::and_exists(f, g, cube);
+}
+
+bdd_ptr bdd_manager::support_cube(const bdd_ptr& f)
+{
+  bdd_manager_scope scope(*this);
+  return ::support_cube(f);
+}
+
+vector<int> bdd_manager::support(const bdd_ptr& f)
+{
+  bdd_manager_scope scope(*this);
+  return ::support(f);
+}
+
+bdd_ptr bdd_manager::compose(const bdd_ptr& f, int var, const bdd_ptr& g)
+{
+  bdd_manager_scope scope(*this);
+  return ::compose(f, var, g);
+}
+
+bdd_ptr bdd_manager::vector_compose(const bdd_ptr& f, const vector<bdd_ptr>& subst)
+{
+  bdd_manager_scope scope(*this);
+  return ::vector_compose(f, subst);
+}
+
+vector<double> bdd_manager::influence(const bdd_ptr& f, const vector<double>& var_prob)
+{
+  bdd_manager_scope scope(*this);
+  return ::influence(f, var_prob);
+}
+
+vector<double> bdd_manager::influence(const bdd_ptr& f)
+{
+  bdd_manager_scope scope(*this);
+  return ::influence(f);
+}
+
+double bdd_manager::probability(const bdd_ptr& f, const vector<double>& var_prob)
+{
+  bdd_manager_scope scope(*this);
+  return ::probability(f, var_prob);
+}
+
+double bdd_manager::probability(const bdd_ptr& f)
+{
+  bdd_manager_scope scope(*this);
+  return ::probability(f);
+}
+
+long double bdd_manager::sat_count(const bdd_ptr& f)
+{
+  bdd_manager_scope scope(*this);
+  return ::sat_count(f);
+}
+
+bdd_ptr bdd_manager::sort_by_influence(const bdd_ptr& np)
+{
+  bdd_manager_scope scope(*this);
+  return ::sort_by_influence(np);
+}
+
+bdd_ptr bdd_manager::zdd_union(const bdd_ptr& p, const bdd_ptr& q)
+{
+  bdd_manager_scope scope(*this);
+  return ::zdd_union(p, q);
+}
+
+bdd_ptr bdd_manager::zdd_intersect(const bdd_ptr& p, const bdd_ptr& q)
+{
+  bdd_manager_scope scope(*this);
+  return ::zdd_intersect(p, q);
+}
+
+bdd_ptr bdd_manager::zdd_diff(const bdd_ptr& p, const bdd_ptr& q)
+{
+  bdd_manager_scope scope(*this);
+  return ::zdd_diff(p, q);
+}
+
+bdd_ptr bdd_manager::zdd_product(const bdd_ptr& p, const bdd_ptr& q)
+{
+  bdd_manager_scope scope(*this);
+  return ::zdd_product(p, q);
+}
+
+long double bdd_manager::zdd_count(const bdd_ptr& p)
+{
+  bdd_manager_scope scope(*this);
+  return ::zdd_count(p);
+}
+
+bdd_ptr bdd_manager::isop(const bdd_ptr& lower, const bdd_ptr& upper)
+{
+  bdd_manager_scope scope(*this);
+  return ::isop(lower, upper);
+}
+
+bdd_ptr bdd_manager::cover_function(const bdd_ptr& p)
+{
+  bdd_manager_scope scope(*this);
+  return ::cover_function(p);
+}
+
+bool bdd_manager::save(const string& path, const vector<bdd_ptr>& roots, string& error)
+{
+  bdd_manager_scope scope(*this);
+  return save_bdds(path, roots, error);
+}
+
+bool bdd_manager::load(const string& path, vector<bdd_ptr>& roots, string& error)
+{
+  bdd_manager_scope scope(*this);
+  return load_bdds(path, roots, error);
+}
+
+bool bdd_manager::load_netlist(const string& path, unsigned int node_budget,
+                               vector<netlist_output>& outputs, netlist_stats& stats,
+                               string& error)
+{
+  bdd_manager_scope scope(*this);
+  return ::load_netlist(path, node_budget, outputs, stats, error);
+}
+
+void bdd_manager::write_dot(ostream& os, const vector<bdd_ptr>& roots, const vector<string>& names)
+{
+  bdd_manager_scope scope(*this);
+  ::write_dot(os, roots, names);
+}
+
+void bdd_manager::write_blif(ostream& os, const vector<bdd_ptr>& roots, const vector<string>& names)
+{
+  bdd_manager_scope scope(*this);
+  ::write_blif(os, roots, names);
+}
+
+void bdd_manager::write_node_table(ostream& os, const vector<bdd_ptr>& roots,
+                                   const vector<string>& names)
+{
+  bdd_manager_scope scope(*this);
+  ::write_node_table(os, roots, names);
+}
+
+void bdd_manager::clear()
+{
+  bdd_manager_scope scope(*this);
+  the_tables.clear();
+}
+
+bdd_tables::compact_stats bdd_manager::compact()
+{
+  bdd_manager_scope scope(*this);
+  return the_tables.compact();
+}
@@ -0,0 +1,164 @@
+#ifndef BDD_MANAGER_H
+#define BDD_MANAGER_H
+
+/*
+ * File bdd_manager.h
+ *
+ * Defines the classes bdd_manager, which owns everything a set of BDDs is
+ * made of, and bdd_manager_scope
+ */
+
+#include <string>
+#include <vector>
+#include "bdd_node.h"
+#include "bdd_tables.h"
+#include "operation.h"
+#include "bdd_netlist.h"
+
+// bdd_manager owns the nodes of a set of BDDs (their store: allocator, ids
+// and terminal node, see bdd_node.h) and the bdd_tables that keep them
+// canonical.  Managers share nothing, so independent BDD jobs can each have
+// their own manager and run on separate threads.  The only exception is the
+// thread pool of the parallel operations (see bdd_parallel.h), which runs
+// one parallel operation at a time; jobs running on separate threads
+// should leave the number of threads at 1.
+//
+// Every thread has a current manager: the default manager, unless it made
+// another one current with a bdd_manager_scope.  bdd_tables::getInstance(),
+// bdd_node::one() and zero(), and the operations in project1.h all work on
+// the current manager.  The operations below are the same ones, run with
+// this manager current.
+//
+// A BDD belongs to the manager it was made in, and may only be passed to
+// operations while that manager is current.  It may be copied or destroyed
+// with any manager current, such as the results the operations below
+// return after their scope has ended: its nodes count their references in
+// their own manager (see bdd_node_store).  Destroying a manager frees the
+// memory of all of its nodes at once, without visiting them; no bdd_ptr to
+// its nodes may be left, and it must not be current on any thread.
+class bdd_manager : public bdd_node_store
+{
+public:
+  bdd_manager();
+  ~bdd_manager();
+
+  // Meyers Singleton Accessor: the manager that threads use unless they
+  // make another one current
+  static bdd_manager& default_manager();
+
+  // the calling thread's current manager
+  static bdd_manager& current() { return static_cast<bdd_manager&>(bdd_node::store()); }
+
+  bdd_tables& tables() { return the_tables; }
+
+  // the BDD of the var with the given name, added if it doesn't exist yet
+  bdd_ptr var(const std::string& name);
+
+  // the operations of project1.h, run with this manager current.  the
+  // arguments are taken by reference, so nothing is done to them before
+  // the manager is current
+  bdd_ptr ite(const bdd_ptr& f, const bdd_ptr& g, const bdd_ptr& h);
+
+  bdd_ptr apply(const bdd_ptr& bdd1, const bdd_ptr& bdd2, const std::string& o);
+  bdd_ptr apply(const bdd_ptr& bdd1, const bdd_ptr& bdd2, operation &op);
+  bdd_ptr apply(const bdd_ptr& bdd1, const bdd_ptr& bdd2, int code);
+
+  bdd_ptr restrict(const bdd_ptr& f, int var, bool value);
+  bdd_ptr cofactor(const bdd_ptr& f, const bdd_ptr& cube);
+
+  bdd_ptr negative_cofactor(const bdd_ptr& np, int var);
+  bdd_ptr positive_cofactor(const bdd_ptr& np, int var);
+  bdd_ptr boolean_difference(const bdd_ptr& np, int var);
+
+  bdd_ptr exists(const bdd_ptr& f, const bdd_ptr& cube);
+  bdd_ptr forall(const bdd_ptr& f, const bdd_ptr& cube);
+  bdd_ptr and_exists(const bdd_ptr& f, const bdd_ptr& g, const bdd_ptr& cube);
+
+  bdd_ptr support_cube(const bdd_ptr& f);
+  std::vector<int> support(const bdd_ptr& f);
+
+  bdd_ptr compose(const bdd_ptr& f, int var, const bdd_ptr& g);
+  bdd_ptr vector_compose(const bdd_ptr& f, const std::vector<bdd_ptr>& subst);
+
+  std::vector<double> influence(const bdd_ptr& f, const std::vector<double>& var_prob);
+  std::vector<double> influence(const bdd_ptr& f);
+
+  double probability(const bdd_ptr& f, const std::vector<double>& var_prob);
+  double probability(const bdd_ptr& f);
+  long double sat_count(const bdd_ptr& f);
+
+  bdd_ptr sort_by_influence(const bdd_ptr& np);
+
+  // the ZDD operations of bdd_zdd.h
+  bdd_ptr zdd_union(const bdd_ptr& p, const bdd_ptr& q);
+  bdd_ptr zdd_intersect(const bdd_ptr& p, const bdd_ptr& q);
+  bdd_ptr zdd_diff(const bdd_ptr& p, const bdd_ptr& q);
+  bdd_ptr zdd_product(const bdd_ptr& p, const bdd_ptr& q);
+  long double zdd_count(const bdd_ptr& p);
+  bdd_ptr isop(const bdd_ptr& lower, const bdd_ptr& upper);
+  bdd_ptr cover_function(const bdd_ptr& p);
+
+  // save_bdds and load_bdds of bdd_io.h, loading into this manager
+  bool save(const std::string& path, const std::vector<bdd_ptr>& roots, std::string& error);
+  bool load(const std::string& path, std::vector<bdd_ptr>& roots, std::string& error);
+
+  // the text exports of bdd_io.h, with the var names of this manager
+  void write_dot(std::ostream& os, const std::vector<bdd_ptr>& roots,
+                 const std::vector<std::string>& names);
+  void write_blif(std::ostream& os, const std::vector<bdd_ptr>& roots,
+                  const std::vector<std::string>& names);
+  void write_node_table(std::ostream& os, const std::vector<bdd_ptr>& roots,
+                        const std::vector<std::string>& names);
+
+  // load_netlist of bdd_netlist.h, building the outputs in this manager
+  bool load_netlist(const std::string& path, unsigned int node_budget,
+                    std::vector<netlist_output>& outputs, netlist_stats& stats,
+                    std::string& error);
+
+  // clears the computed table and collects all garbage (see
+  // bdd_tables::clear)
+  void clear();
+
+  // moves the nodes into level order in memory (see bdd_tables::compact)
+  bdd_tables::compact_stats compact();
+
+private:
+  friend class bdd_manager_scope;
+
+  // dissallow copy and assignment
+  bdd_manager(const bdd_manager&);
+  bdd_manager& operator=(const bdd_manager&);
+
+  // makes manager the calling thread's current one, and returns the one
+  // that was current before
+  static bdd_manager* make_current(bdd_manager* manager);
+
+  bdd_tables the_tables;
+};
+
+// bdd_manager_scope makes a manager current on the calling thread for as
+// long as it exists, and then restores the one that was current before:
+//
+//   bdd_manager job;
+//   {
+//     bdd_manager_scope scope(job);
+//     bdd_ptr f = apply(job.var("a"), job.var("b"), "and");
+//     ...
+//   }
+class bdd_manager_scope
+{
+public:
+  explicit bdd_manager_scope(bdd_manager& manager) :
+    previous(bdd_manager::make_current(&manager))
+  {}
+  ~bdd_manager_scope() { bdd_manager::make_current(previous); }
+
+private:
+  // dissallow copy and assignment
+  bdd_manager_scope(const bdd_manager_scope&);
+  bdd_manager_scope& operator=(const bdd_manager_scope&);
+
+  bdd_manager* previous;
+};
+
+#endif
@@ -0,0 +1,417 @@
+/*
+ * File bdd_netlist.cpp
+ *
+ * Contains the implementation of the netlist builder, declared in
+ * bdd_netlist.h
+ */
+
+#include "bdd_netlist.h"
+#include "bdd_tables.h"
+#include "operation.h"
+#include "project1.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <set>
+#include <sstream>
+#include <sys/time.h>
+
+using namespace std;
+
+// a signal of the netlist: a primary input, or the output of a .names
+struct net_signal
+{
+  net_signal() : input(false), defined(false), on_set(true), state(0), uses(0) {}
+
+  string name;
+  bool input;
+  bool defined;           // by a .names
+  vector<int> fanins;
+  vector<string> cubes;   // the input part of every row of the cover
+  bool on_set;            // whether the rows are on-set rows
+
+  int state;              // 0 unvisited, 1 on the search stack, 2 done
+  int uses;               // gates left to read bdd, plus 1 for an output
+  bdd_ptr bdd;
+};
+
+// a netlist as it is read, with its signals in the order they first appear
+struct netlist
+{
+  string model;
+  vector<net_signal> signals;
+  map<string, int> index;
+  vector<int> inputs;
+  vector<int> outputs;
+
+  int signal(const string& name)
+  {
+    map<string, int>::iterator it = index.find(name);
+    if (it != index.end()) return it->second;
+
+    signals.push_back(net_signal());
+    signals.back().name = name;
+    index[name] = signals.size() - 1;
+    return signals.size() - 1;
+  }
+};
+
+// wall clock time in seconds
+static double now()
+{
+  timeval tv;
+  gettimeofday(&tv, 0);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+// number of nodes in roots together, the terminal included
+static unsigned int node_count(const vector<bdd_ptr>& roots)
+{
+  set<bdd_node*> visited;
+  vector<bdd_node*> stack;
+  for (size_t i = 0; i < roots.size(); ++i) stack.push_back(roots[i].node());
+  while (!stack.empty())
+  {
+    bdd_node* n = stack.back();
+    stack.pop_back();
+
+    if (!visited.insert(n).second || n->is_terminal()) continue;
+    stack.push_back(n->neg_cf.node());
+    stack.push_back(n->pos_cf.node());
+  }
+  return visited.size();
+}
+
+// reads the next line of is into words, with the lines it goes on on
+// joined to it and comments dropped, and advances line_no past them.
+// returns false at the end of is
+static bool read_words(istream& is, int& line_no, vector<string>& words)
+{
+  words.clear();
+  string line;
+  while (getline(is, line))
+  {
+    ++line_no;
+    size_t comment = line.find('#');
+    if (comment != string::npos) line.erase(comment);
+
+    bool goes_on = false;
+    size_t last = line.find_last_not_of(" \t\r");
+    if (last != string::npos && line[last] == '\\')
+    {
+      goes_on = true;
+      line.erase(last);
+    }
+
+    istringstream ss(line);
+    string word;
+    while (ss >> word) words.push_back(word);
+
+    if (!goes_on && !words.empty()) return true;
+  }
+  return !words.empty();
+}
+
+// reads the netlist in is into net.  returns false and sets error if it is
+// malformed
+static bool read_netlist(istream& is, netlist& net, string& error)
+{
+  int line_no = 0;
+  int gate = -1;  // the .names whose rows come next
+  vector<string> words;
+
+  while (read_words(is, line_no, words))
+  {
+    const string& key = words[0];
+    ostringstream where;
+    where << "line " << line_no << ": ";
+
+    if (key[0] != '.')
+    {
+      if (gate < 0)
+      {
+        error = where.str() + "cover row outside of a .names";
+        return false;
+      }
+
+      net_signal& s = net.signals[gate];
+      string cube = s.fanins.empty() ? "" : key;
+      string value = s.fanins.empty() ? key : (words.size() > 1 ? words[1] : "");
+      if (words.size() != (s.fanins.empty() ? 1u : 2u) ||
+          cube.size() != s.fanins.size() ||
+          cube.find_first_not_of("01-") != string::npos ||
+          (value != "0" && value != "1"))
+      {
+        error = where.str() + "malformed cover row of " + s.name;
+        return false;
+      }
+      if (!s.cubes.empty() && s.on_set != (value == "1"))
+      {
+        error = where.str() + "on-set and off-set rows mixed in the cover of " + s.name;
+        return false;
+      }
+      s.on_set = (value == "1");
+      s.cubes.push_back(cube);
+    }
+    else if (key == ".model")
+    {
+      gate = -1;
+      if (words.size() > 1) net.model = words[1];
+    }
+    else if (key == ".inputs" || key == ".outputs")
+    {
+      gate = -1;
+      for (size_t i = 1; i < words.size(); ++i)
+      {
+        int s = net.signal(words[i]);
+        if (key == ".outputs")
+        {
+          net.outputs.push_back(s);
+        }
+        else if (!net.signals[s].input)
+        {
+          net.signals[s].input = true;
+          net.inputs.push_back(s);
+        }
+      }
+    }
+    else if (key == ".names")
+    {
+      if (words.size() < 2)
+      {
+        error = where.str() + ".names without an output";
+        return false;
+      }
+      gate = net.signal(words.back());
+      if (net.signals[gate].defined)
+      {
+        error = where.str() + words.back() + " is defined twice";
+        return false;
+      }
+      net.signals[gate].defined = true;
+      for (size_t i = 1; i + 1 < words.size(); ++i)
+      {
+        int fanin = net.signal(words[i]);
+        net.signals[gate].fanins.push_back(fanin);
+      }
+    }
+    else if (key == ".end")
+    {
+      break;
+    }
+    else
+    {
+      error = where.str() + key + " isn't supported";
+      return false;
+    }
+  }
+
+  for (size_t i = 0; i < net.signals.size(); ++i)
+  {
+    const net_signal& s = net.signals[i];
+    if (s.input && s.defined)
+    {
+      error = s.name + " is an input and is defined by a .names";
+      return false;
+    }
+    if (!s.input && !s.defined)
+    {
+      error = s.name + " is never defined";
+      return false;
+    }
+  }
+  return true;
+}
+
+// the gates and inputs the outputs of net depend on, fanins first, in
+// order.  the ones first reached from output i are order[ends[i - 1]] to
+// order[ends[i] - 1].  returns false and sets error if there is a
+// combinational loop
+static bool search(netlist& net, vector<int>& order, vector<size_t>& ends, string& error)
+{
+  // signal, index of its next fanin
+  vector<pair<int, size_t> > stack;
+
+  for (size_t i = 0; i < net.outputs.size(); ++i)
+  {
+    int output = net.outputs[i];
+    if (net.signals[output].state == 0)
+    {
+      net.signals[output].state = 1;
+      stack.push_back(make_pair(output, (size_t)0));
+    }
+
+    while (!stack.empty())
+    {
+      net_signal& s = net.signals[stack.back().first];
+      if (stack.back().second < s.fanins.size())
+      {
+        int fanin = s.fanins[stack.back().second++];
+        if (net.signals[fanin].state == 1)
+        {
+          error = "combinational loop through " + net.signals[fanin].name;
+          return false;
+        }
+        if (net.signals[fanin].state == 0)
+        {
+          net.signals[fanin].state = 1;
+          stack.push_back(make_pair(fanin, (size_t)0));
+        }
+      }
+      else
+      {
+        s.state = 2;
+        order.push_back(stack.back().first);
+        stack.pop_back();
+      }
+    }
+    ends.push_back(order.size());
+  }
+  return true;
+}
+
+// the BDD of the cover of s, over the BDDs of its fanins
+static bdd_ptr gate_bdd(const netlist& net, const net_signal& s)
+{
+  bdd_ptr sum = bdd_node::zero();
+  for (size_t i = 0; i < s.cubes.size(); ++i)
+  {
+    bdd_ptr product = bdd_node::one();
+    for (size_t j = 0; j < s.fanins.size(); ++j)
+    {
+      char c = s.cubes[i][j];
+      if (c == '-') continue;
+
+      const bdd_ptr& fanin = net.signals[s.fanins[j]].bdd;
+      product = apply(product, (c == '1') ? fanin : fanin.complement(), OP_AND);
+    }
+    sum = apply(sum, product, OP_OR);
+  }
+  return s.on_set ? sum : sum.complement();
+}
+
+// one less gate (or output) left to read the BDD of s
+static void release(net_signal& s)
+{
+  if (--s.uses == 0) s.bdd = bdd_ptr();
+}
+
+bool build_netlist(istream& is, unsigned int node_budget, vector<netlist_output>& outputs,
+                   netlist_stats& stats, string& error)
+{
+  double start = now();
+  outputs.clear();
+  stats = netlist_stats();
+
+  netlist net;
+  vector<int> order;
+  vector<size_t> ends;
+  if (!read_netlist(is, net, error) || !search(net, order, ends, error)) return false;
+
+  bdd_tables& tables = bdd_tables::getInstance();
+  stats.model = net.model;
+  stats.inputs = net.inputs.size();
+
+  // the vars, in the order of the search
+  for (size_t i = 0; i < order.size(); ++i)
+  {
+    net_signal& s = net.signals[order[i]];
+    if (s.input)
+    {
+      s.bdd = tables.var_bdd(tables.add_var(s.name));
+    }
+    else
+    {
+      ++stats.gates;
+      for (size_t j = 0; j < s.fanins.size(); ++j) ++net.signals[s.fanins[j]].uses;
+    }
+  }
+  for (size_t i = 0; i < net.inputs.size(); ++i)
+  {
+    tables.add_var(net.signals[net.inputs[i]].name);
+  }
+  for (size_t i = 0; i < net.outputs.size(); ++i)
+  {
+    ++net.signals[net.outputs[i]].uses;
+  }
+
+  size_t next = 0;
+  for (size_t i = 0; i < net.outputs.size(); ++i)
+  {
+    netlist_output out;
+    double output_start = now();
+    for (; next < ends[i]; ++next)
+    {
+      net_signal& s = net.signals[order[next]];
+      if (s.input) continue;
+
+      s.bdd = gate_bdd(net, s);
+      for (size_t j = 0; j < s.fanins.size(); ++j) release(net.signals[s.fanins[j]]);
+      ++out.gates;
+
+      if (node_budget && bdd_node::live_count() > node_budget)
+      {
+        tables.collect_garbage();
+        if (bdd_node::live_count() > node_budget)
+        {
+          ostringstream msg;
+          msg << "node budget of " << node_budget << " exceeded at " << s.name;
+          error = msg.str();
+          stats.peak_nodes = tables.stats().peak_nodes;
+          stats.seconds = now() - start;
+          return false;
+        }
+      }
+    }
+
+    net_signal& s = net.signals[net.outputs[i]];
+    out.name = s.name;
+    out.bdd = s.bdd;
+    out.seconds = now() - output_start;
+    out.nodes = node_count(vector<bdd_ptr>(1, out.bdd));
+    release(s);
+    outputs.push_back(out);
+  }
+
+  vector<bdd_ptr> roots;
+  for (size_t i = 0; i < outputs.size(); ++i) roots.push_back(outputs[i].bdd);
+  stats.shared_nodes = node_count(roots);
+  stats.peak_nodes = tables.stats().peak_nodes;
+  stats.seconds = now() - start;
+  return true;
+}
+
+bool load_netlist(const string& path, unsigned int node_budget, vector<netlist_output>& outputs,
+                  netlist_stats& stats, string& error)
+{
+  ifstream is(path.c_str());
+  if (!is)
+  {
+    error = path + ": " + strerror(errno);
+    return false;
+  }
+  return build_netlist(is, node_budget, outputs, stats, error);
+}
+
+void print_netlist_stats(ostream& os, const vector<netlist_output>& outputs,
+                         const netlist_stats& stats)
+{
+  os << "model " << stats.model << ": " << stats.inputs << " inputs, " << stats.gates
+     << " gates, " << outputs.size() << " outputs built" << endl;
+
+  os << setw(16) << "output" << setw(10) << "gates" << setw(10) << "nodes"
+     << setw(12) << "time (s)" << endl;
+  for (size_t i = 0; i < outputs.size(); ++i)
+  {
+    const netlist_output& out = outputs[i];
+    os << setw(16) << out.name << setw(10) << out.gates << setw(10) << out.nodes
+       << setw(12) << out.seconds << endl;
+  }
+
+  os << "shared nodes:      " << stats.shared_nodes << endl
+     << "peak nodes:        " << stats.peak_nodes << endl
+     << "total time:        " << stats.seconds << " s" << endl;
+}
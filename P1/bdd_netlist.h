@@ -0,0 +1,81 @@
+#ifndef BDD_NETLIST_H
+#define BDD_NETLIST_H
+
+/*
+ * File bdd_netlist.h
+ *
+ * Builds the BDDs of all of the outputs of a BLIF netlist at once
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "bdd_node.h"
+
+// The netlist is a combinational BLIF model: .model, .inputs, .outputs,
+// .names with the rows of its cover, and .end.  A line ending in \ goes on
+// on the next one, and # starts a comment.  The rows of a cover are either
+// all on-set (output 1) or all off-set (output 0) rows; a .names without
+// rows is the constant 0.  .latch, .subckt and the other constructs are
+// rejected.
+//
+// The outputs are built in the tables of the current manager, so they
+// share their nodes.  A depth first search from the outputs, in the order
+// of .outputs, visiting the fanins of a gate in the order of its .names,
+// gives both the order in which the gates are built (every gate after its
+// fanins) and the order of the vars: the inputs get their vars in the
+// order the search reaches them, so inputs that feed the same gates end
+// up close together.  Inputs that already have a var keep it.  Inputs no
+// output depends on are added last.
+//
+// The BDD of a gate is dropped as soon as the last gate that reads it has
+// been built, unless it is an output, so only the frontier of the netlist
+// is alive at any time.  After each gate, if more than node_budget nodes
+// are alive (0 means no budget), the dead ones are collected, and if that
+// is not enough, the build stops.
+
+// an output of the netlist, and what building it took
+struct netlist_output
+{
+  netlist_output() : gates(0), nodes(0), seconds(0) {}
+
+  std::string name;
+  bdd_ptr bdd;
+  unsigned int gates;   // the gates first needed by this output
+  unsigned int nodes;   // in bdd, the terminal included
+  double seconds;       // to build those gates
+};
+
+// the totals of a build
+struct netlist_stats
+{
+  netlist_stats() : inputs(0), gates(0), shared_nodes(0), peak_nodes(0), seconds(0) {}
+
+  std::string model;
+  unsigned int inputs;
+  unsigned int gates;         // reached from the outputs
+  unsigned int shared_nodes;  // in all of the outputs together
+  unsigned int peak_nodes;    // the most the unique table has held since
+                              // its counters were reset (see
+                              // bdd_tables::table_stats)
+  double seconds;
+};
+
+// reads the netlist from is and builds its outputs, in the order of
+// .outputs.  returns false and sets error if the netlist is malformed
+// (outputs is left empty) or the budget is exceeded (outputs has the ones
+// that were finished)
+bool build_netlist(std::istream& is, unsigned int node_budget,
+                   std::vector<netlist_output>& outputs, netlist_stats& stats,
+                   std::string& error);
+
+// build_netlist on the file at path
+bool load_netlist(const std::string& path, unsigned int node_budget,
+                  std::vector<netlist_output>& outputs, netlist_stats& stats,
+                  std::string& error);
+
+// prints a line per output and the totals
+void print_netlist_stats(std::ostream& os, const std::vector<netlist_output>& outputs,
+                         const netlist_stats& stats);
+
+#endif
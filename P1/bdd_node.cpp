@@ -6,6 +6,25 @@
  * Modified 9/23/2004 by Karl Rosaen
  *  - use of smart pointers
  *
+ * Modified for complemented edges
+ *
+ * Modified to allocate nodes from a bdd_allocator
+ *
+ * Modified for integer variables
+ *
+ * Modified for garbage collection
+ *
+ * Modified to print and search BDDs without recursion
+ *
+ * Modified to look vars up in cached support cubes
+ *
+ * Modified to find probabilities by a pass over the BDD instead of
+ * keeping one in every node
+ *
+ * Modified for parallel operations
+ *
+ * Modified for bdd_managers
+ *
  * Contains definitions of static variables and class methods for 
  * the class bdd_node, defined in bdd_node.h, as well as a couple
  * of helper functions
@@ -14,158 +33,229 @@
 #include <iostream>
 #include <string>
 #include <map>
+#include <set>
+#include <vector>
 #include <cassert>
+#include <new>
 
 #include "bdd_node.h"
+#include "bdd_tables.h"
+#include "project1.h"
 
 using namespace std;
 
-// definition of inital id
-int bdd_node::id_ctr = 0;
-set<int> bdd_node::free_ids;
+__thread bdd_node_store* bdd_node::current_store = 0;
 
 // default = print out ids
 bool bdd_node::print_verbose = true;
 
-// definition of terminal nodes
-bdd_ptr bdd_node::zero = new bdd_node();
-bdd_ptr bdd_node::one = new bdd_node();
+bdd_node_store* bdd_node_store::registry[bdd_node_store::max_stores];
+
+// protects the registry, for stores made and destroyed on several threads
+static volatile int registry_lock = 0;
+
+// the store takes the first free index in the registry.  the terminal node
+// is the first node of the store.  the store isn't current yet, so its
+// references from one and zero are counted here
+bdd_node_store::bdd_node_store() :
+  allocator(sizeof(bdd_node)), dead_nodes(0), threaded(false), allocator_lock(0),
+  index(0)
+{
+  while (__sync_lock_test_and_set(&registry_lock, 1)) {}
+  while (index < max_stores && registry[index]) ++index;
+  assert(index < max_stores);
+  registry[index] = this;
+  __sync_lock_release(&registry_lock);
+
+  bdd_node* terminal = bdd_node::create(*this);
+  terminal->ref_count = 2;
+  --dead_nodes;
+
+  one_edge.bits = reinterpret_cast<size_t>(terminal);
+  zero_edge.bits = one_edge.bits | 1;
+}
+
+// the nodes aren't destroyed one by one, the allocator frees their chunks
+bdd_node_store::~bdd_node_store()
+{
+  one_edge.bits = 0;
+  zero_edge.bits = 0;
+
+  while (__sync_lock_test_and_set(&registry_lock, 1)) {}
+  registry[index] = 0;
+  __sync_lock_release(&registry_lock);
+}
 
-// default ctr
-bdd_node::bdd_node() : neg_cf(0), pos_cf(0)
+// ctr, id is the index of the slot the node is constructed in, in the
+// allocator of the store with index store_in
+bdd_node::bdd_node(int id_in, int store_in) :
+  var(-1), store_index(store_in), neg_cf(0), pos_cf(0), ref_count(0), id(id_in)
 {
-  // creation of first node, initialize free_ids
-  if (id_ctr == 0)
+}
+
+// takes a slot from the allocator of s and constructs a node in it.
+// nothing refers to the new node yet, so it starts out dead
+bdd_node* bdd_node::create(bdd_node_store& s)
+{
+  int slot_id;
+  void* p;
+  if (s.threaded)
   {
-    id_ctr = 100;
-    for (int i = 0; i < bdd_node::id_ctr; ++i)
-    {
-      bdd_node::free_ids.insert(i);
-    }
+    while (__sync_lock_test_and_set(&s.allocator_lock, 1)) {}
+    p = s.allocator.allocate(slot_id);
+    __sync_lock_release(&s.allocator_lock);
+    __sync_fetch_and_add(&s.dead_nodes, 1);
   }
-  
-  if (free_ids.empty())
+  else
   {
-    for (int i = id_ctr; i < 2*id_ctr; i++)
-    {
-      free_ids.insert(i);
-    }
-    id_ctr = 2*id_ctr;
+    p = s.allocator.allocate(slot_id);
+    ++s.dead_nodes;
   }
-  id = *(free_ids.begin());
-  free_ids.erase(id);
+  return new (p) bdd_node(slot_id, s.index);
 }
 
-
-bdd_node::~bdd_node()
+// destroys the node, and frees up its slot and id
+void bdd_node::release(bdd_node* node)
 {
-  // free up this node's id
-  free_ids.insert(get_id());
+  assert(node->ref_count == 0);
+
+  bdd_node_store& s = node->owner();
+  int slot_id = node->id;
+  node->~bdd_node();
+  if (s.threaded)
+  {
+    __sync_fetch_and_sub(&s.dead_nodes, 1);
+    while (__sync_lock_test_and_set(&s.allocator_lock, 1)) {}
+    s.allocator.release(slot_id);
+    __sync_lock_release(&s.allocator_lock);
+  }
+  else
+  {
+    --s.dead_nodes;
+    s.allocator.release(slot_id);
+  }
 }
 
 
 ostream& operator<< (ostream& os, bdd_ptr bnode)
 {
-  bnode->print(os);
+  bnode.print(os);
   return os;
 }
 
 
 
-// output the contents of the BDD made up of this bdd_node and 
-// its children by recursively visiting all of the nodes and outputting
+// output the contents of the BDD made up of this edge's node and
+// its children by visiting all of the nodes and outputting
 // their contents.  This is essentially a pre-order visitiation with
 // some fancy formatting to make the output more readable
 // the convention is that nodes down and to the right are the postive 
 // cofactor, and nodes straight down are the negative cofactor
-// verbose = true means print out each non-terminal node's id too
-void bdd_node::print(ostream& os)
+// verbose = true means print out each non-terminal node's id too,
+// preceded by a ! if it is reached through a complemented edge
+//
+// the edges still to be printed are kept on a stack, each with the spacing
+// in front of its line, so deep BDDs don't overflow the call stack
+void bdd_ptr::print(ostream& os) const
 {
-  static string spacing("");
-  
-  string prefix;
-  if (spacing.size() != 0)
-  {
-    prefix = spacing.substr(0, spacing.size() - 3) + " |__";
-  }
-  else
-  {
-    prefix = spacing;
-  }
-  if (is_zero())
-  {
-    os << prefix << "0\n";
-  }
-  else if (is_one())
-  {
-    os << prefix << "1\n";
-  }
-  else
+  vector<pair<bdd_ptr, string> > stack(1, make_pair(*this, string("")));
+
+  while (!stack.empty())
   {
-    if (print_verbose)
+    bdd_ptr edge = stack.back().first;
+    string spacing = stack.back().second;
+    stack.pop_back();
+
+    string prefix;
+    if (spacing.size() != 0)
     {
-      os << prefix << var << " " << get_id() << endl;
+      prefix = spacing.substr(0, spacing.size() - 3) + " |__";
     }
     else
     {
-      os << prefix << var << endl;
+      prefix = spacing;
+    }
+    if (edge.is_zero())
+    {
+      os << prefix << "0\n";
+    }
+    else if (edge.is_one())
+    {
+      os << prefix << "1\n";
+    }
+    else
+    {
+      const string& name = bdd_tables::getInstance().var_name(edge.var());
+      if (bdd_node::print_mode())
+      {
+        os << prefix << name << " " << (edge.is_complemented() ? "!" : "") << edge.get_id() << endl;
+      }
+      else
+      {
+        os << prefix << name << endl;
+      }
     }
-  }
 
-  if (!is_terminal())
-  {
-    spacing += " | ";
-    pos_cf->print(os);
-    spacing.resize(spacing.size() - 3);
-  
-    spacing += "   ";
-    neg_cf->print(os);
-    spacing.resize(spacing.size() - 3);  
+    // the positive cofactor is printed first, so it goes on top
+    if (!edge.is_terminal())
+    {
+      stack.push_back(make_pair(edge.neg_cf(), spacing + "   "));
+      stack.push_back(make_pair(edge.pos_cf(), spacing + " | "));
+    }
   }
 }
 
 
-// figures out whether or not the BDD pointed to by this node
-// has a given variable
-bool bdd_node::has_var(char thevar)
+double bdd_ptr::probability() const
 {
-  if (is_terminal() || var > thevar)
-  {
-    return false;
-  }
-  if (var == thevar)
+  return ::probability(*this);
+}
+
+// figures out whether or not the BDD pointed to by this edge
+// has a given variable, by looking it up in the support cube of the BDD
+// (see support_cube in project1.cpp).  the cube is cached, so only the
+// first call on a BDD visits its nodes; after that, the cube's vars above
+// thevar's level are all that is looked at.  support_cube may reorder the
+// vars, so thevar's level is only read once the cube is there
+bool bdd_ptr::has_var(int thevar) const
+{
+  bdd_tables& tables = bdd_tables::getInstance();
+  bdd_ptr cube = support_cube(*this);
+  int lvl = tables.level(thevar);
+
+  for (; tables.top_level(cube) <= lvl; cube = cube.pos_cf())
   {
-    return true;
+    if (cube.var() == thevar)
+    {
+      return true;
+    }
   }
-  return (pos_cf->has_var(thevar) || neg_cf->has_var(thevar));
+  return false;
 }
 
 // the Apply function, given two BDDs (at least one of them must be non-terminal), 
-// needs to be able to choose a next var to split on.  Vars that are lower
-// alphabetically have precedance (i.e d is prefered over f etc.)
-char find_next_var(bdd_ptr bdd1, bdd_ptr bdd2)
+// needs to be able to choose a next var to split on.  Vars at lower
+// levels have precedance (see bdd_tables.h)
+int find_next_var(bdd_ptr bdd1, bdd_ptr bdd2)
 {
-  // both bdd's aren't terminal, return lower alphabetically
-  if (!bdd1->is_terminal() && !bdd2->is_terminal())
+  bdd_tables& tables = bdd_tables::getInstance();
+
+  // both bdd's aren't terminal, return the one at the lower level
+  if (!bdd1.is_terminal() && !bdd2.is_terminal())
   {
-    return (bdd1->var < bdd2->var) ? bdd1->var : bdd2->var;
+    return (tables.level(bdd1.var()) < tables.level(bdd2.var())) ? bdd1.var() : bdd2.var();
   }
   
   // only bdd1 terminal
-  if (!bdd1->is_terminal())
+  if (!bdd1.is_terminal())
   {
-    return bdd1->var;
+    return bdd1.var();
   }
   else
   {
     // this assert will alert you if this function is called
     // incorrectly (on two terminal nodes)
-    assert (!bdd2->is_terminal());
-    return bdd2->var;
+    assert (!bdd2.is_terminal());
+    return bdd2.var();
   }
 }
-
-
-
-
-
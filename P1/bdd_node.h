@@ -8,21 +8,180 @@
  * Modified 9/22/2004 by Karl Rosaen
  *  - added use of smart pointers
  *
+ * Modified to use complemented edges
+ *  - bdd_ptr is now an edge that may carry a complement bit
+ *  - zero is the complement of one
+ *
+ * Modified to allocate nodes from a bdd_allocator
+ *  - a node's id is the index of its slot
+ *  - bdd_node keeps its own reference count
+ *
+ * Modified for integer variables (see bdd_tables.h)
+ *
+ * Modified for garbage collection
+ *  - a node whose count drops to zero is dead, not released; dead nodes
+ *    are released in batches by bdd_tables::collect_garbage
+ *
+ * Modified for parallel operations
+ *  - in threaded mode, counts are updated atomically and allocation is
+ *    serialized
+ *
+ * Modified for bdd_managers
+ *  - the allocator, the terminal node and the dead count moved into
+ *    bdd_node_store, one per manager
+ *  - one and zero are functions returning the current manager's terminals
+ *  - a node keeps the index of its store, so reference counts are kept
+ *    in the store the node belongs to, whichever manager is current
+ *
+ * Modified to drop the probability kept in every node; bdd_ptr's
+ * probability() is found by a pass over the BDD
+ *
  * Contains definition of class Bdd_node and prototypes for
  * helper functions
  */
 
 #include <iostream>
-#include <set>
+#include <cstddef>
 
-#include "smart_pointer.h"
+#include "bdd_allocator.h"
 
 class bdd_node;
 class bdd_tables;
+class bdd_manager;
+
+// all pointers to Bdd_nodes will be handeled with bdd_ptr, a reference
+// counting smart pointer whose lowest bit marks a complemented edge.  A
+// complemented edge to a node represents the negation of the function
+// rooted at that node, so negating a BDD is just flipping that bit.
+//
+// The accessors below are edge-aware: neg_cf() and pos_cf() return the
+// cofactors of the function the edge represents (the node's children with
+// the complement pushed down).  node() gives access to the underlying
+// (regular) node.
+class bdd_ptr
+{
+  // used to test a bdd_ptr for null in conditionals
+  typedef size_t bdd_ptr::*unspecified_bool_type;
+
+public:
+  // regular edge to node
+  bdd_ptr(bdd_node* node = 0);
+  bdd_ptr(const bdd_ptr& other);
+  ~bdd_ptr();
+
+  bdd_ptr& operator= (const bdd_ptr& rhs);
+
+  // the node this edge points to
+  bdd_node* node() const
+    { return reinterpret_cast<bdd_node*>(bits & ~(size_t)1); }
+
+  bool is_complemented() const { return (bits & 1) != 0; }
+
+  // the same node with the complement bit flipped, i.e. the negated function
+  bdd_ptr complement() const { return from_bits(bits ^ 1); }
+
+  // the same node without the complement bit
+  bdd_ptr regular() const { return from_bits(bits & ~(size_t)1); }
+
+  bool is_terminal() const;
+  bool is_one() const;
+  bool is_zero() const;
+
+  // the var that is split on (irrelevant for terminals)
+  int var() const;
+
+  // the unique id of the underlying node
+  int get_id() const;
+
+  // probability that the function is 1 if every var is 1 with probability
+  // .5, found by a pass over the BDD (see probability in project1.h)
+  double probability() const;
+
+  // negative and positive cofactors w.r.t. var()
+  bdd_ptr neg_cf() const;
+  bdd_ptr pos_cf() const;
+
+  // returns whether or not the BDD depends on a certain variable
+  bool has_var(int thevar) const;
+
+  // prints the contents of the BDD by visiting all of the nodes
+  void print(std::ostream& os = std::cout) const;
+
+  bool operator== (const bdd_ptr& rhs) const { return bits == rhs.bits; }
+  bool operator!= (const bdd_ptr& rhs) const { return bits != rhs.bits; }
+
+  operator unspecified_bool_type() const { return bits ? &bdd_ptr::bits : 0; }
+
+  // the tables refer to nodes through the raw bits of edges, which aren't
+  // counted as references (see bdd_tables.h).  a store sets up its
+  // terminal edges before it is anyone's current store
+  friend class bdd_tables;
+  friend class bdd_node_store;
+
+private:
+  // the edge with the given address and complement flag
+  static bdd_ptr from_bits(size_t tagged);
+
+  size_t bits; // address of the node, with the complement flag in bit 0
+};
+
+// bdd_node_store
+// Where the nodes of a bdd_manager (see bdd_manager.h) come from: the
+// allocator that provides their memory and their ids, the terminal node,
+// and the number of dead nodes.  Each manager has its own store, so the
+// ids of different managers overlap, and their nodes must never be mixed.
+//
+// bdd_node creates nodes in the store of the calling thread's current
+// manager.  Every node remembers the index of the store it was created in,
+// and a reference count change updates the dead count (and checks the
+// threaded mode) of that store, so a bdd_ptr may be copied or destroyed
+// while another manager is current.  Only the thread that works with a
+// manager may touch its BDDs, though.
+//
+// A store is torn down without visiting its nodes: their memory goes away
+// with the allocator's chunks.
+class bdd_node_store
+{
+public:
+  // the terminal node, and its complement
+  const bdd_ptr& one() const { return one_edge; }
+  const bdd_ptr& zero() const { return zero_edge; }
+
+  // number of nodes allocated, dead ones included, and of those that
+  // nothing refers to
+  unsigned int live_count() const { return allocator.live_count(); }
+  unsigned int dead_count() const { return dead_nodes; }
+
+  // the most stores that may exist at once
+  static const int max_stores = 1024;
+
+protected:
+  bdd_node_store();
+  ~bdd_node_store();
+
+private:
+  friend class bdd_node;
+
+  // dissallow copy and assignment
+  bdd_node_store(const bdd_node_store&);
+  bdd_node_store& operator=(const bdd_node_store&);
 
-// all pointers to Bdd_nodes will be handeled 
-// with smart pointers
-typedef smart_pointer<bdd_node> bdd_ptr;
+  // provides the storage, and ids, for the nodes
+  bdd_allocator allocator;
+
+  unsigned int dead_nodes; // number of nodes with a zero ref_count
+  bool threaded;
+
+  volatile int allocator_lock; // spin lock for the allocator when threaded
+
+  bdd_ptr one_edge;
+  bdd_ptr zero_edge;
+
+  int index; // in registry
+
+  // the stores that exist, by index, for the nodes to find theirs in
+  static bdd_node_store* registry[max_stores];
+};
 
 // bdd_node
 // The buiding block for BDDs.  Contains a variable that is split on
@@ -30,75 +189,198 @@ typedef smart_pointer<bdd_node> bdd_ptr;
 // w.r.t var, and class methods that act on entire BDDs that are made
 // up of the Bdd_node and its children
 //
-// Two static nodes are declared that are the two unique terminal nodes, 
-// one and zero
-class bdd_node : public Reference_Counted_Object
+// To keep the representation canonical, pos_cf is never a complemented
+// edge; neg_cf may be.
+//
+// There is a single terminal node per manager, one.  zero is a complemented
+// edge to it.
+//
+// Nodes live in the slots of their manager's bdd_allocator; a node's
+// id is the index of its slot.  A node counts the bdd_ptrs that point to
+// it: those held by the program and those of its parents.  It does not
+// release itself when the count drops to zero.  It becomes dead instead,
+// and stays where it is (and in the unique table) until the garbage
+// collector releases it, unless a new reference brings it back to life
+// first.  Releasing one node thus never turns into a recursive cascade
+// over its descendants.
+class bdd_node
 {
 public:
 
-  ~bdd_node();
+  // allocates and constructs a node (with null children)
+  static bdd_node* create() { return create(store()); }
+
+  // number of nodes currently allocated, dead ones included
+  static unsigned int live_count() { return store().allocator.live_count(); }
 
-  // the bdd_ctr used to give each created node its unique id
-  static int id_ctr;
-  static std::set<int> free_ids;
+  // number of allocated nodes of the current store that nothing refers to
+  static unsigned int dead_count() { return store().dead_nodes; }
 
-  // the terminal nodes used by every BDD
-  static bdd_ptr one;
-  static bdd_ptr zero;
+  // the terminal node used by every BDD, and its complement
+  static const bdd_ptr& one() { return store().one(); }
+  static const bdd_ptr& zero() { return store().zero(); }
+
+  // the store of the calling thread's current manager
+  static bdd_node_store& store()
+  {
+    if (!current_store) current_store = &default_store();
+    return *current_store;
+  }
 
   // this node's unique id
   int get_id() { return id; }
 
-  // only the terminal nodes (one and zero) will have null children
-  bool is_terminal() { return (neg_cf == 0); }
+  // only the terminal node will have null children
+  bool is_terminal() { return (!neg_cf); }
+
+  void increment_ref_count()
+  {
+    bdd_node_store& s = owner();
+    if (s.threaded)
+    {
+      if (__sync_fetch_and_add(&ref_count, 1) == 0) __sync_fetch_and_sub(&s.dead_nodes, 1);
+    }
+    else if (ref_count++ == 0)
+    {
+      --s.dead_nodes;
+    }
+  }
 
-  bool is_zero() {return (this == zero); }
-  bool is_one() {return (this == one); }
+  // the node is dead once no bdd_ptr refers to it
+  void decrement_ref_count()
+  {
+    bdd_node_store& s = owner();
+    if (s.threaded)
+    {
+      if (__sync_sub_and_fetch(&ref_count, 1) == 0) __sync_fetch_and_add(&s.dead_nodes, 1);
+    }
+    else if (--ref_count == 0)
+    {
+      ++s.dead_nodes;
+    }
+  }
 
-  // prints the contents of the BDD by recursively visiting all of the nodes
-  void print(std::ostream& os = std::cout);
+  unsigned int get_ref_count() const { return ref_count; }
 
   // read and set print mode
   static bool print_mode() {return print_verbose;}
   static void set_print_mode(bool val) {print_verbose = val;}
 
-  // returns whether or not the tree has a certain variable
-  bool has_var(char thevar);
-  
-  // the var that is split on.  irrelevant for static (class wide) nodes one and zero
-  char var;
+  // the var that is split on.  irrelevant for the terminal node
+  int var;
 
-  // children = smart pointers to bdd_nodes representing the positive and
+private:
+  // the index of the store the node lives in (see bdd_node_store).  it
+  // sits next to var, in what would be padding before the children
+  int store_index;
+
+public:
+  // children = edges to bdd_nodes representing the positive and
   // negative cofactors with respect to var
-  // both nodes = 0 means this is a leaf node
+  // both null means this is a leaf node
   bdd_ptr neg_cf;
   bdd_ptr pos_cf;
-  
-  float probability; //holds the probability of each node
-		    // must be assigned after each node is created
-  
-
 
   friend class bdd_tables;
+  friend class bdd_node_store;
+  friend class bdd_manager;
 
 private:
-  // can only be created by Bdd_tables
-  bdd_node();
+  // can only be created by create()
+  bdd_node(int id_in, int store_in);
+  ~bdd_node() {}
+
+  // dissallow copy and assignment
+  bdd_node(const bdd_node&);
+  bdd_node& operator=(const bdd_node&);
+
+  static bdd_node* create(bdd_node_store& s);
+
+  // the store this node was created in
+  bdd_node_store& owner() const { return *bdd_node_store::registry[store_index]; }
+
+  // destroys a dead node and returns its slot to the allocator
+  static void release(bdd_node* node);
+
+  // the allocator of the current store, for bdd_tables::compact
+  static bdd_allocator& allocator() { return store().allocator; }
+
+  // while threaded is set (by bdd_tables, for the duration of a parallel
+  // operation) nodes may be created and referred to by several threads
+  static void set_threaded(bool val) { store().threaded = val; }
 
-  
+  // the store of the default manager (defined in bdd_manager.cpp)
+  static bdd_node_store& default_store();
+
+  unsigned int ref_count; // number of bdd_ptrs pointing to this node
   int id;  // the unique id of this node
-  
+
+  // null until the thread first uses a store, or makes a manager current
+  static __thread bdd_node_store* current_store;
+
   static bool print_verbose; // whether or not to print the node's ids
 };
 
 
+// bdd_ptr members that need the complete bdd_node
+
+inline bdd_ptr::bdd_ptr(bdd_node* n) : bits(reinterpret_cast<size_t>(n))
+{
+  if (n) n->increment_ref_count();
+}
+
+inline bdd_ptr bdd_ptr::from_bits(size_t tagged)
+{
+  bdd_ptr edge;
+  edge.bits = tagged;
+  if (tagged) edge.node()->increment_ref_count();
+  return edge;
+}
+
+inline bdd_ptr::bdd_ptr(const bdd_ptr& other) : bits(other.bits)
+{
+  if (bits) node()->increment_ref_count();
+}
+
+inline bdd_ptr::~bdd_ptr()
+{
+  if (bits) node()->decrement_ref_count();
+}
+
+inline bdd_ptr& bdd_ptr::operator= (const bdd_ptr& rhs)
+{
+  if (bits != rhs.bits)
+  {
+    if (rhs.bits) rhs.node()->increment_ref_count();
+    if (bits) node()->decrement_ref_count();
+    bits = rhs.bits;
+  }
+  return *this;
+}
+
+inline bool bdd_ptr::is_terminal() const { return node()->is_terminal(); }
+inline bool bdd_ptr::is_one() const { return node()->is_terminal() && !is_complemented(); }
+inline bool bdd_ptr::is_zero() const { return node()->is_terminal() && is_complemented(); }
+inline int bdd_ptr::var() const { return node()->var; }
+inline int bdd_ptr::get_id() const { return node()->get_id(); }
+
+inline bdd_ptr bdd_ptr::neg_cf() const
+{
+  return from_bits(node()->neg_cf.bits ^ (bits & 1));
+}
+
+inline bdd_ptr bdd_ptr::pos_cf() const
+{
+  return from_bits(node()->pos_cf.bits ^ (bits & 1));
+}
+
+
 // allows a Bdd to be fed into a stream, i.e cout << bdd1
 std::ostream& operator<< (std::ostream& os, bdd_ptr bnode);
 
-// returns the next var to be split on (used in Apply).  Lower value vars
-// have precedence
-char find_next_var(bdd_ptr bdd1, bdd_ptr bdd2);
+// returns the next var to be split on (used in Apply).  Vars at lower
+// levels have precedence
+int find_next_var(bdd_ptr bdd1, bdd_ptr bdd2);
 
 
 #endif
-
@@ -0,0 +1,270 @@
+/*
+ * File bdd_parallel.cpp
+ *
+ * Contains the implementation of the class methods of bdd_thread_pool,
+ * defined in bdd_parallel.h
+ */
+
+#include "bdd_parallel.h"
+#include <sched.h>
+#include <cassert>
+
+using namespace std;
+
+// the index of the pool thread running on this thread, -1 for others
+static __thread int worker_id = -1;
+
+// per-thread state for picking victims
+static __thread unsigned int steal_seed = 1;
+
+// what a pool thread is started with
+struct worker_arg
+{
+  bdd_thread_pool* pool;
+  int id;
+};
+
+bdd_thread_pool::bdd_thread_pool() :
+  num_workers(1), active(false), shutting_down(false)
+{
+  pthread_mutex_init(&state_lock, 0);
+  pthread_cond_init(&wakeup, 0);
+  pthread_mutex_init(&run_lock, 0);
+  start_threads(1);
+}
+
+bdd_thread_pool::~bdd_thread_pool()
+{
+  stop_threads();
+  pthread_mutex_destroy(&run_lock);
+  pthread_cond_destroy(&wakeup);
+  pthread_mutex_destroy(&state_lock);
+}
+
+// Meyers Singleton Accessor
+bdd_thread_pool& bdd_thread_pool::getInstance()
+{
+  static bdd_thread_pool the_pool;
+  return the_pool;
+}
+
+void bdd_thread_pool::set_num_threads(int n)
+{
+  if (n < 1) n = 1;
+  if (n == num_workers) return;
+
+  stop_threads();
+  start_threads(n);
+}
+
+// deque 0 belongs to the thread that calls run(); the others get a thread
+// each
+void bdd_thread_pool::start_threads(int n)
+{
+  num_workers = n;
+  shutting_down = false;
+
+  for (int i = 0; i < n; ++i)
+  {
+    worker_deque* deque = new worker_deque;
+    pthread_mutex_init(&deque->lock, 0);
+    deque->top = 0;
+    deque->waiting = 0;
+    deques.push_back(deque);
+  }
+
+  for (int i = 1; i < n; ++i)
+  {
+    worker_arg* arg = new worker_arg;
+    arg->pool = this;
+    arg->id = i;
+
+    pthread_t thread;
+    pthread_create(&thread, 0, worker_main, arg);
+    threads.push_back(thread);
+  }
+}
+
+void bdd_thread_pool::stop_threads()
+{
+  pthread_mutex_lock(&state_lock);
+  shutting_down = true;
+  pthread_cond_broadcast(&wakeup);
+  pthread_mutex_unlock(&state_lock);
+
+  for (size_t i = 0; i < threads.size(); ++i)
+  {
+    pthread_join(threads[i], 0);
+  }
+  threads.clear();
+
+  for (size_t i = 0; i < deques.size(); ++i)
+  {
+    pthread_mutex_destroy(&deques[i]->lock);
+    delete deques[i];
+  }
+  deques.clear();
+}
+
+// a pool thread sleeps until there is a computation, and then steals tasks
+// until the computation is over
+void* bdd_thread_pool::worker_main(void* arg_in)
+{
+  worker_arg* arg = static_cast<worker_arg*>(arg_in);
+  bdd_thread_pool* pool = arg->pool;
+  worker_id = arg->id;
+  steal_seed = arg->id * 2654435761u + 1;
+  delete arg;
+
+  for (;;)
+  {
+    if (!pool->active)
+    {
+      pthread_mutex_lock(&pool->state_lock);
+      while (!pool->active && !pool->shutting_down)
+      {
+        pthread_cond_wait(&pool->wakeup, &pool->state_lock);
+      }
+      bool stop = pool->shutting_down;
+      pthread_mutex_unlock(&pool->state_lock);
+      if (stop) break;
+    }
+
+    bdd_task* task = pool->steal(worker_id);
+    if (task)
+    {
+      pool->execute(task);
+    }
+    else
+    {
+      sched_yield();
+    }
+  }
+  return 0;
+}
+
+void bdd_thread_pool::run(bdd_task& root)
+{
+  if (num_workers == 1)
+  {
+    root.run();
+    return;
+  }
+
+  pthread_mutex_lock(&run_lock);
+  assert(worker_id < 0);
+  worker_id = 0;
+
+  pthread_mutex_lock(&state_lock);
+  active = true;
+  pthread_cond_broadcast(&wakeup);
+  pthread_mutex_unlock(&state_lock);
+
+  execute(&root);
+
+  // everything root spawned has been synced, so the deques are empty
+  active = false;
+  worker_id = -1;
+  pthread_mutex_unlock(&run_lock);
+}
+
+void bdd_thread_pool::execute(bdd_task* task)
+{
+  task->run();
+  // a full barrier: the syncing thread sees the result once it sees done
+  __sync_fetch_and_or(&task->done, 1);
+}
+
+void bdd_thread_pool::spawn(bdd_task& task)
+{
+  if (num_workers == 1)
+  {
+    // there is no one to hand it to.  sync runs it
+    return;
+  }
+
+  worker_deque* deque = deques[worker_id];
+  pthread_mutex_lock(&deque->lock);
+  deque->tasks.push_back(&task);
+  ++deque->waiting;
+  pthread_mutex_unlock(&deque->lock);
+}
+
+void bdd_thread_pool::sync(bdd_task& task)
+{
+  if (num_workers == 1)
+  {
+    task.run();
+    return;
+  }
+
+  // everything spawned after task has been synced already, so task is at
+  // the bottom of the deque unless it was stolen
+  worker_deque* deque = deques[worker_id];
+  bool mine = false;
+  pthread_mutex_lock(&deque->lock);
+  if (deque->tasks.size() > deque->top && deque->tasks.back() == &task)
+  {
+    deque->tasks.pop_back();
+    --deque->waiting;
+    if (deque->tasks.size() == deque->top)
+    {
+      deque->tasks.clear();
+      deque->top = 0;
+    }
+    mine = true;
+  }
+  pthread_mutex_unlock(&deque->lock);
+
+  if (mine)
+  {
+    execute(&task);
+    return;
+  }
+
+  while (!__sync_fetch_and_or(&task.done, 0))
+  {
+    bdd_task* other = steal(worker_id);
+    if (other)
+    {
+      execute(other);
+    }
+    else
+    {
+      sched_yield();
+    }
+  }
+}
+
+// tries every other deque once, starting at a random one
+bdd_task* bdd_thread_pool::steal(int thief)
+{
+  steal_seed = steal_seed * 1103515245u + 12345u;
+  int start = (steal_seed >> 16) % num_workers;
+
+  for (int i = 0; i < num_workers; ++i)
+  {
+    int victim = (start + i) % num_workers;
+    if (victim == thief) continue;
+
+    worker_deque* deque = deques[victim];
+    if (deque->waiting == 0) continue; // checked again below
+
+    bdd_task* task = 0;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->tasks.size() > deque->top)
+    {
+      task = deque->tasks[deque->top++];
+      --deque->waiting;
+      if (deque->tasks.size() == deque->top)
+      {
+        deque->tasks.clear();
+        deque->top = 0;
+      }
+    }
+    pthread_mutex_unlock(&deque->lock);
+
+    if (task) return task;
+  }
+  return 0;
+}
@@ -0,0 +1,108 @@
+#ifndef BDD_PARALLEL_H
+#define BDD_PARALLEL_H
+
+/*
+ * File bdd_parallel.h
+ *
+ * Defines the classes bdd_task and bdd_thread_pool, which run the parallel
+ * BDD operations
+ */
+
+#include <vector>
+#include <pthread.h>
+
+// a piece of work that can be handed to other threads.  subclasses hold
+// the arguments and the result, and do the work in run()
+class bdd_task
+{
+public:
+  bdd_task() : done(0) {}
+  virtual ~bdd_task() {}
+
+  virtual void run() = 0;
+
+private:
+  friend class bdd_thread_pool;
+
+  volatile int done; // set once run() has returned
+};
+
+// bdd_thread_pool runs fork-join computations on a fixed set of threads,
+// by work stealing.  Every thread has a deque of tasks.  A task spawns a
+// subtask by pushing it on the bottom of its thread's deque, and later
+// syncs with it: if the subtask is still there, it is popped and run right
+// away; otherwise another thread stole it from the top of the deque, and
+// the syncing thread steals and runs other tasks until it is done.  Idle
+// threads steal from the top of random deques.  Stealing from the top
+// takes the oldest, and so usually the largest, pending task.
+//
+// The deques are short and each is protected by its own lock, so the locks
+// are rarely contended.  Between parallel computations the threads sleep.
+//
+// The thread that calls run() takes part as thread 0.  With one thread (the
+// default), no threads are started and run() just runs the task.
+class bdd_thread_pool
+{
+public:
+  // Meyers Singleton Accessor
+  static bdd_thread_pool& getInstance();
+
+  // the number of threads working on a computation, the caller of run()
+  // included.  changing it stops the current threads and starts new ones
+  void set_num_threads(int n);
+  int num_threads() const { return num_workers; }
+
+  // runs root, and everything it spawns, to completion.  not reentrant.
+  // the pool runs one computation at a time: a call from another thread
+  // waits for the current one to finish
+  void run(bdd_task& root);
+
+  // called from a running task: makes task available to other threads.
+  // the task must be synced before the spawning task returns
+  void spawn(bdd_task& task);
+
+  // called from the task that spawned task: returns once it is done
+  void sync(bdd_task& task);
+
+private:
+  bdd_thread_pool();
+  ~bdd_thread_pool();
+
+  // dissallow copy and assignment
+  bdd_thread_pool(const bdd_thread_pool&);
+  bdd_thread_pool& operator=(const bdd_thread_pool&);
+
+  // tasks[top, tasks.size()) are waiting; the bottom is the back.
+  // waiting is their number, which thieves may read without the lock
+  struct worker_deque
+  {
+    pthread_mutex_t lock;
+    std::vector<bdd_task*> tasks;
+    size_t top;
+    volatile size_t waiting;
+  };
+
+  static void* worker_main(void* arg);
+
+  void start_threads(int n);
+  void stop_threads();
+
+  void execute(bdd_task* task);
+
+  // takes the top task of another thread's deque, or returns 0
+  bdd_task* steal(int thief);
+
+  int num_workers;
+  std::vector<worker_deque*> deques;
+  std::vector<pthread_t> threads;
+
+  // the threads sleep on wakeup while there is no computation
+  pthread_mutex_t state_lock;
+  pthread_cond_t wakeup;
+
+  pthread_mutex_t run_lock; // held for the duration of run()
+  volatile bool active;
+  volatile bool shutting_down;
+};
+
+#endif
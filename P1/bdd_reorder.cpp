@@ -0,0 +1,272 @@
+/*
+ * File bdd_reorder.cpp
+ *
+ * Contains the class methods of bdd_tables, defined in bdd_tables.h, that
+ * change the variable order: swapping adjacent levels, and sifting.
+ *
+ * Sifting (R. Rudell, "Dynamic variable ordering for ordered binary
+ * decision diagrams", ICCAD 1993) moves one var at a time through all
+ * levels by swapping it with its neighbours, keeping the others in place,
+ * and leaves it at the level where the unique table was smallest.
+ */
+
+#include "bdd_tables.h"
+#include <iostream>
+#include <algorithm>
+#include <functional>
+#include <cassert>
+
+using namespace std;
+
+// the vars at levels lvl (x) and lvl + 1 (y) trade places.
+//
+// x nodes that don't depend on y stay as they are.  every other x node
+// F = x' (y' F00 + y F01) + x (y' F10 + y F11) is rewritten in place into
+// the y node F = y' (x' F00 + x F10) + y (x' F01 + x F11), creating the two
+// x nodes it needs.  F keeps its id and its function, so every reference
+// to it is still valid.  y nodes that were only used by the rewritten x
+// nodes are dead afterwards, and are released along with any other dead
+// nodes of the two levels
+unsigned int bdd_tables::swap_levels(int lvl)
+{
+  assert(lvl >= 0 && lvl + 1 < num_vars());
+
+  int x = level_to_var[lvl];
+  int y = level_to_var[lvl + 1];
+  subtable& x_table = unique_table[x];
+  subtable& y_table = unique_table[y];
+
+  // empty the x subtable, putting back the nodes that stay x nodes
+  vector<bdd_node*> old_slots(x_table.slots.size(), (bdd_node*)0);
+  old_slots.swap(x_table.slots);
+  unique_count -= x_table.count;
+  x_table.count = 0;
+
+  vector<bdd_node*> moved;
+  for (vector<bdd_node*>::iterator it = old_slots.begin(); it != old_slots.end(); ++it)
+  {
+    if (!*it) continue;
+    bdd_node* node = *it;
+
+    if ((!node->neg_cf.is_terminal() && node->neg_cf.var() == y) ||
+        (!node->pos_cf.is_terminal() && node->pos_cf.var() == y))
+    {
+      moved.push_back(node);
+    }
+    else
+    {
+      insert_in_subtable(node);
+    }
+  }
+  old_slots.clear();
+
+  var_to_level[x] = lvl + 1;
+  var_to_level[y] = lvl;
+  level_to_var[lvl] = y;
+  level_to_var[lvl + 1] = x;
+
+  for (vector<bdd_node*>::iterator it = moved.begin(); it != moved.end(); ++it)
+  {
+    bdd_node* node = *it;
+
+    // cofactors of the children w.r.t. y.  f1 is a regular edge, so f11 is too
+    bdd_ptr f0 = node->neg_cf;
+    bdd_ptr f1 = node->pos_cf;
+    bdd_ptr f00 = f0, f01 = f0, f10 = f1, f11 = f1;
+    if (!f0.is_terminal() && f0.var() == y)
+    {
+      f00 = f0.neg_cf();
+      f01 = f0.pos_cf();
+    }
+    if (!f1.is_terminal() && f1.var() == y)
+    {
+      f10 = f1.neg_cf();
+      f11 = f1.pos_cf();
+    }
+
+    bdd_ptr neg = get_node(x, f00, f10);
+    bdd_ptr pos = get_node(x, f01, f11);
+    assert(!pos.is_complemented());
+
+    node->var = y;
+    node->neg_cf = neg;
+    node->pos_cf = pos;
+
+    if (y_table.count + 1 > max_load * y_table.slots.size())
+    {
+      grow_subtable(y_table);
+    }
+    insert_in_subtable(node);
+  }
+  moved.clear();
+
+  // the old y nodes (and x nodes, for that matter) that lost their last
+  // parent are dead now
+  int vars[2] = { y, x };
+  for (int v = 0; v < 2; ++v)
+  {
+    subtable& table = unique_table[vars[v]];
+    vector<bdd_node*> dead;
+    for (size_t i = 0; i < table.slots.size(); ++i)
+    {
+      if (table.slots[i] && table.slots[i]->get_ref_count() == 0)
+      {
+        dead.push_back(table.slots[i]);
+      }
+    }
+    for (size_t i = 0; i < dead.size(); ++i)
+    {
+      erase_dead(dead[i]);
+    }
+  }
+
+  ++swap_count;
+  return unique_count;
+}
+
+// moves var to level lvl by swapping it with its neighbours, and returns
+// the number of nodes afterwards
+int bdd_tables::move_to_level(int var, int lvl)
+{
+  while (var_to_level[var] < lvl)
+  {
+    swap_levels(var_to_level[var]);
+  }
+  while (var_to_level[var] > lvl)
+  {
+    swap_levels(var_to_level[var] - 1);
+  }
+  return unique_count;
+}
+
+// sifts var: first towards the nearer end of the order, then all the way
+// to the other end, and finally back to the best level seen.  a direction
+// is abandoned once the table has grown by more than max_growth
+void bdd_tables::sift(int var, clock_t deadline)
+{
+  int last = num_vars() - 1;
+  int lvl = var_to_level[var];
+  int best_lvl = lvl;
+  unsigned int best_size = unique_count;
+
+  int first_dir = (last - lvl < lvl) ? 1 : -1;
+  for (int pass = 0; pass < 2; ++pass)
+  {
+    int dir = (pass == 0) ? first_dir : -first_dir;
+    while ((dir > 0) ? lvl < last : lvl > 0)
+    {
+      unsigned int size = swap_levels((dir > 0) ? lvl : lvl - 1);
+      lvl += dir;
+
+      if (size < best_size)
+      {
+        best_size = size;
+        best_lvl = lvl;
+      }
+      else if (size > max_growth * best_size || clock() > deadline)
+      {
+        break;
+      }
+    }
+  }
+
+  move_to_level(var, best_lvl);
+}
+
+// sifts the vars one at a time, those with the most nodes first.  the
+// computed table is cleared first, since swapping levels releases nodes
+// that its entries may refer to.
+//
+// ZDD vars aren't sifted: swap_levels rewrites nodes the BDD way.  BDD vars
+// are sifted past them, which leaves their nodes as they are, since a BDD
+// node never has a ZDD node as a child, and vice versa
+bdd_tables::reorder_stats bdd_tables::reorder()
+{
+  assert(op_depth == 0);
+
+  reorder_stats stats;
+  clock_t start = clock();
+  clock_t deadline = start + (clock_t)(reorder_time_limit * CLOCKS_PER_SEC);
+
+  clear_computed_table();
+  collect_garbage();
+  stats.nodes_before = unique_count;
+  swap_count = 0;
+
+  vector<pair<unsigned int, int> > vars;
+  for (int var = 0; var < num_vars(); ++var)
+  {
+    if (!zdd_vars[var]) vars.push_back(make_pair(unique_table[var].count, var));
+  }
+  sort(vars.begin(), vars.end(), greater<pair<unsigned int, int> >());
+
+  for (size_t i = 0; i < vars.size() && vars[i].first > 0; ++i)
+  {
+    if (clock() > deadline) break;
+    sift(vars[i].second, deadline);
+  }
+
+  stats.nodes_after = unique_count;
+  stats.swaps = swap_count;
+  stats.seconds = double(clock() - start) / CLOCKS_PER_SEC;
+
+  last_reorder_stats = stats;
+  return stats;
+}
+
+// reorders when the unique table has passed the threshold, and sets the
+// next threshold to twice the resulting size
+void bdd_tables::auto_reorder()
+{
+  reorder_stats stats = reorder();
+  next_reorder = max(reorder_threshold, 2 * stats.nodes_after);
+
+  if (reorder_verbose)
+  {
+    cout << "reordering: " << stats.nodes_before << " -> " << stats.nodes_after
+         << " nodes, " << stats.swaps << " swaps, " << stats.seconds << " s" << endl;
+  }
+}
+
+// order is level -> var.  it must contain every var exactly once, and the
+// ZDD vars in their current order.  each var in turn is moved up to its
+// level, past vars that aren't placed yet, so no two ZDD vars are swapped
+bool bdd_tables::set_var_order(const vector<int>& order)
+{
+  assert(op_depth == 0);
+
+  if ((int)order.size() != num_vars())
+  {
+    return false;
+  }
+
+  vector<bool> seen(num_vars(), false);
+  for (int lvl = 0; lvl < num_vars(); ++lvl)
+  {
+    int var = order[lvl];
+    if (var < 0 || var >= num_vars() || seen[var])
+    {
+      return false;
+    }
+    seen[var] = true;
+  }
+
+  int last_zdd_level = -1;
+  for (int lvl = 0; lvl < num_vars(); ++lvl)
+  {
+    if (!zdd_vars[order[lvl]]) continue;
+    if (var_to_level[order[lvl]] < last_zdd_level)
+    {
+      return false;
+    }
+    last_zdd_level = var_to_level[order[lvl]];
+  }
+
+  clear_computed_table();
+  collect_garbage();
+  for (int lvl = 0; lvl < num_vars(); ++lvl)
+  {
+    move_to_level(order[lvl], lvl);
+  }
+  return true;
+}
@@ -6,18 +6,43 @@
  * Contains the implementation of the class methods of bdd_tables, defined
  * in bdd_tables.h
  */
- 
+
 #include "bdd_tables.h"
+#include "bdd_manager.h"
+#include "bdd_truth_table.h"
 #include <iostream>
 #include <iomanip> // for setw
+#include <sstream>
+#include <algorithm>
+#include <cassert>
+#include <new>
 
 using namespace std;
 
+const unsigned int bdd_tables::initial_subtable_size;
+const unsigned int bdd_tables::initial_computed_size;
+const unsigned int bdd_tables::max_computed_size;
+const int bdd_tables::terminal_level;
+const double bdd_tables::max_load = 0.75;
+const unsigned int bdd_tables::min_gc_dead;
+const unsigned int bdd_tables::max_probe;
+const unsigned int bdd_tables::parallel_computed_size;
+const int bdd_tables::num_overflow_locks;
+
+
+const char* computed_op_name(int op)
+{
+  static const char* names[NUM_COMPUTED_OPS] = { "ite", "cof", "andex", "supp", "comp", "zunion",
+                                                    "zinter", "zdiff", "zprod", "zchg", "isop",
+                                                    "isopf", "cover" };
+  return (op >= 0 && op < NUM_COMPUTED_OPS) ? names[op] : "?";
+}
 
 bool computed_table_key::operator<(const computed_table_key& other) const
 {
   return( (op < other.op) ||
-          (op == other.op && make_pair(lhs, rhs) < make_pair(other.lhs, other.rhs))
+          (op == other.op && make_pair(f, make_pair(g, h)) <
+                             make_pair(other.f, make_pair(other.g, other.h)))
         );
 }
 
@@ -26,113 +51,1045 @@ bool unique_table_key::operator< (const unique_table_key& rhs) const
 {
   return( (var < rhs.var) ||
           (var == rhs.var && neg_cf_id < rhs.neg_cf_id) ||
-          (var == rhs.var && neg_cf_id == rhs.neg_cf_id && pos_cf_id < rhs.pos_cf_id)
+          (var == rhs.var && neg_cf_id == rhs.neg_cf_id && neg_comp < rhs.neg_comp) ||
+          (var == rhs.var && neg_cf_id == rhs.neg_cf_id && neg_comp == rhs.neg_comp &&
+           pos_cf_id < rhs.pos_cf_id)
         );
 }
 
 
-// Meyers Singleton Accessor
+bdd_tables::bdd_tables() :
+  computed_table(initial_computed_size), computed_count(0),
+  unique_count(0),
+  reordering(false), reorder_verbose(false),
+  reorder_threshold(4096), next_reorder(4096), truth_table_levels(10),
+  max_growth(1.2), reorder_time_limit(60), swap_count(0),
+  gc_fraction(0.25), stats_start(clock()),
+  op_depth(0), concurrent(false)
+{
+  for (int i = 0; i < num_overflow_locks; ++i)
+  {
+    pthread_mutex_init(&overflow_locks[i], 0);
+  }
+  pthread_mutex_init(&crowded_lock, 0);
+}
+
+// the nodes belong to the manager's store, which frees them
+bdd_tables::~bdd_tables()
+{
+  for (int i = 0; i < num_overflow_locks; ++i)
+  {
+    pthread_mutex_destroy(&overflow_locks[i]);
+  }
+  pthread_mutex_destroy(&crowded_lock);
+}
+
 bdd_tables& bdd_tables::getInstance()
 {
-  // create the tables only the first time this is called
-  // (happens automatically since the_tables is static)
-  static bdd_tables the_tables;
-  return the_tables;
+  return bdd_manager::current().tables();
+}
+
+// an edge as an integer: its node id and complement bit.  a null
+// operand (one the operation doesn't use) is no_edge
+static const unsigned int no_edge = ~0u;
+
+static inline unsigned int edge_key(const bdd_ptr& edge)
+{
+  if (!edge) return no_edge;
+  return ((unsigned int)edge.get_id() << 1) | (edge.is_complemented() ? 1 : 0);
+}
+
+// the same, for the raw bits of an edge
+static inline unsigned int edge_key(size_t bits)
+{
+  if (!bits) return no_edge;
+  bdd_node* node = reinterpret_cast<bdd_node*>(bits & ~(size_t)1);
+  return ((unsigned int)node->get_id() << 1) | (unsigned int)(bits & 1);
+}
+
+// hash functions for the two tables.  the keys are mixed multiplicatively
+// so that nodes with consecutive ids land in different slots; callers mask
+// the result with the (power of two) table size
+unsigned int bdd_tables::computed_hash(int op, size_t f, size_t g, size_t h)
+{
+  unsigned int k = edge_key(f) * 12582917u;
+  k = (k ^ edge_key(g)) * 4256249u;
+  k = (k ^ edge_key(h)) * 1273393u;
+  k = (k ^ (unsigned int)op) * 741457u;
+  return k ^ (k >> 15);
+}
+
+unsigned int bdd_tables::unique_hash(const bdd_ptr& neg, const bdd_ptr& pos)
+{
+  unsigned int h = edge_key(neg) * 2246822519u;
+  h = (h ^ edge_key(pos)) * 3266489917u;
+  return h ^ (h >> 16);
 }
 
 // checks to see if the result exists in the computed table.  If so, it returns
 // a pointer to the resulting node.  otherwise, returns 0
-bdd_ptr bdd_tables::find_in_computed_table(const string& op, bdd_ptr bdd1, bdd_ptr bdd2)
+bdd_ptr bdd_tables::find_in_computed_table(int op, const bdd_ptr& f, const bdd_ptr& g, const bdd_ptr& h)
 {
-  computed_table_t::iterator it = computed_table.find(
-    computed_table_key(op, bdd1->get_id(), bdd2->get_id()));
-  if (it != computed_table.end())
+  unsigned int mask = computed_table.size() - 1;
+  computed_entry& entry = computed_table[computed_hash(op, f.bits, g.bits, h.bits) & mask];
+
+  if (concurrent)
+  {
+    // read a copy, and only use it if no one wrote to the entry meanwhile
+    unsigned int version = entry.version;
+    if (version & 1) return 0;
+    __sync_synchronize();
+    computed_entry copy;
+    copy.op = entry.op;
+    copy.f = entry.f;
+    copy.g = entry.g;
+    copy.h = entry.h;
+    copy.result = entry.result;
+    __sync_synchronize();
+    if (entry.version != version) return 0;
+
+    if (copy.op == op && copy.f == f.bits && copy.g == g.bits && copy.h == h.bits)
+    {
+      return bdd_ptr::from_bits(copy.result);
+    }
+    return 0;
+  }
+
+  ++counters.computed_lookups[op];
+  if (entry.op == op && entry.f == f.bits && entry.g == g.bits && entry.h == h.bits)
   {
-    return(*it).second;
+    ++counters.computed_hits[op];
+    // the result may be a dead node, which this brings back to life
+    return bdd_ptr::from_bits(entry.result);
   }
-    
+
   return 0;
 }
 
-// adds an entry to the computed table
-void bdd_tables::insert_computed_table(const string& op, bdd_ptr bdd1, bdd_ptr bdd2, bdd_ptr computed_node)
+// adds an entry to the computed table, replacing whatever was in its slot
+void bdd_tables::insert_computed_table(int op, const bdd_ptr& f, const bdd_ptr& g, const bdd_ptr& h,
+                                       const bdd_ptr& computed_node)
 {
-  computed_table[computed_table_key(op, bdd1->get_id(), bdd2->get_id())] = computed_node;
+  unsigned int mask = computed_table.size() - 1;
+  computed_entry& entry = computed_table[computed_hash(op, f.bits, g.bits, h.bits) & mask];
+
+  if (concurrent)
+  {
+    // another thread is writing the entry, or just got to it first
+    unsigned int version = entry.version;
+    if ((version & 1) || !__sync_bool_compare_and_swap(&entry.version, version, version + 1))
+    {
+      return;
+    }
+    if (entry.op < 0)
+    {
+      __sync_fetch_and_add(&computed_count, 1);
+    }
+    entry.op = op;
+    entry.f = f.bits;
+    entry.g = g.bits;
+    entry.h = h.bits;
+    entry.result = computed_node.bits;
+    __sync_synchronize();
+    entry.version = version + 2;
+    return;
+  }
+
+  if (entry.op < 0)
+  {
+    ++computed_count;
+  }
+  entry.op = op;
+  entry.f = f.bits;
+  entry.g = g.bits;
+  entry.h = h.bits;
+  entry.result = computed_node.bits;
+
+  if (computed_count > max_load * computed_table.size() &&
+      computed_table.size() < max_computed_size)
+  {
+    grow_computed_table();
+  }
+}
+
+void bdd_tables::clear_computed_table()
+{
+  computed_table.assign(initial_computed_size, computed_entry());
+  computed_count = 0;
 }
 
-// looks in the unique table and sees if an entry already exists for a variable and 
+// doubles the computed table.  entries that collide in the new table are
+// dropped, like any other overwrite
+void bdd_tables::grow_computed_table()
+{
+  computed_table_t old_table(2 * computed_table.size());
+  old_table.swap(computed_table);
+  computed_count = 0;
+
+  unsigned int mask = computed_table.size() - 1;
+  for (computed_table_t::iterator it = old_table.begin(); it != old_table.end(); ++it)
+  {
+    if (it->op < 0) continue;
+
+    computed_entry& entry =
+      computed_table[computed_hash(it->op, it->f, it->g, it->h) & mask];
+    if (entry.op < 0)
+    {
+      ++computed_count;
+    }
+    entry = *it;
+  }
+}
+
+// looks in the unique table and sees if an entry already exists for a variable and
 // two prospective children.  returns the bdd_node ptr if it finds it, otherwise
 // returns 0
-bdd_ptr bdd_tables::find_in_unique_table(char var, bdd_ptr left, bdd_ptr right)
+bdd_ptr bdd_tables::find_in_unique_table(int var, bdd_ptr left, bdd_ptr right)
 {
-  unique_table_t::iterator it = unique_table.find(unique_table_key(var, left->get_id(), right->get_id()));
+  subtable& table = unique_table[var];
+  unsigned int mask = table.slots.size() - 1;
+  unsigned int i = unique_hash(left, right) & mask;
+  ++counters.unique_lookups;
 
-  // if a unique entry exists, return that
-  if (it != unique_table.end())
+  // probe until the node or an empty slot is found
+  for (; table.slots[i]; i = (i + 1) & mask)
   {
-    return(*it).second;
+    bdd_node* node = table.slots[i];
+    if (node->neg_cf == left && node->pos_cf == right)
+    {
+      // brings node back to life if it was dead
+      ++counters.unique_hits;
+      return node;
+    }
+    ++counters.unique_collisions;
   }
   return 0;
 }
 
 // create a new node with var "var", and children "left" and "right", and insert it into the unique table
-// returns a pointer to the new node
-bdd_ptr bdd_tables::create_and_add_to_unique_table(char var, bdd_ptr left, bdd_ptr right)
+// returns a pointer to the new node.  the node must not be in the table already,
+// and right must not be a complemented edge
+bdd_ptr bdd_tables::create_and_add_to_unique_table(int var, bdd_ptr left, bdd_ptr right)
 {
+  assert(!right.is_complemented());
+
   // make a new entry, insert it and return it
-  bdd_ptr new_node = new bdd_node();
-  new_node->var = var;
-  
-  new_node->neg_cf = left;
-  new_node->pos_cf = right;
+  bdd_node* node = new_node(var, left, right);
+
+  subtable& table = unique_table[var];
+  if (table.count + 1 > max_load * table.slots.size())
+  {
+    grow_subtable(table);
+  }
+  insert_in_subtable(node);
+
+  ++counters.nodes_created;
+  if (unique_count > counters.peak_nodes) counters.peak_nodes = unique_count;
+  return node;
+}
+
+bdd_node* bdd_tables::new_node(int var, const bdd_ptr& left, const bdd_ptr& right)
+{
+  bdd_node* node = bdd_node::create();
+  node->var = var;
+
+  node->neg_cf = left;
+  node->pos_cf = right;
+  return node;
+}
+
+// finds the node var' left + var right, or adds it, while other threads
+// may be doing the same (see bdd_tables.h).  a node made for a slot or the
+// overflow map that someone else filled first is released again
+bdd_ptr bdd_tables::find_or_add_concurrent(int var, const bdd_ptr& left, const bdd_ptr& right)
+{
+  assert(!right.is_complemented());
+
+  subtable& table = unique_table[var];
+  unsigned int mask = table.slots.size() - 1;
+  unsigned int i = unique_hash(left, right) & mask;
+  bdd_node* created = 0;
+
+  unsigned int probe = 0;
+  for (; probe < max_probe && probe <= mask; ++probe, i = (i + 1) & mask)
+  {
+    bdd_node* volatile* slot = &table.slots[i];
+    bdd_node* node = *slot;
+    if (!node)
+    {
+      if (!created)
+      {
+        created = new_node(var, left, right);
+      }
+      if (__sync_bool_compare_and_swap(slot, (bdd_node*)0, created))
+      {
+        unsigned int count = __sync_add_and_fetch(&table.count, 1);
+        __sync_fetch_and_add(&unique_count, 1);
+        if (count > max_load * table.slots.size())
+        {
+          mark_crowded(var);
+        }
+        return created;
+      }
+      node = *slot;
+    }
+    if (node->neg_cf == left && node->pos_cf == right)
+    {
+      if (created) bdd_node::release(created);
+      return node;
+    }
+  }
+
+  // outside of parallel mode nodes are inserted without a probe limit, so
+  // the node may also lie further on, up to the first empty slot.  no
+  // thread puts it there in this mode, and slots are never emptied, so if
+  // it isn't there it can only be in the overflow map
+  for (; probe <= mask; ++probe, i = (i + 1) & mask)
+  {
+    bdd_node* node = table.slots[i];
+    if (!node) break;
+    if (node->neg_cf == left && node->pos_cf == right)
+    {
+      if (created) bdd_node::release(created);
+      return node;
+    }
+  }
+
+  pthread_mutex_t* lock = &overflow_locks[var % num_overflow_locks];
+  pthread_mutex_lock(lock);
+
+  bdd_ptr res;
+  child_key key(left.bits, right.bits);
+  map<child_key, bdd_node*>::iterator it = table.overflow.find(key);
+  if (it != table.overflow.end())
+  {
+    res = it->second;
+  }
+  else
+  {
+    if (!created)
+    {
+      created = new_node(var, left, right);
+    }
+    table.overflow[key] = created;
+    __sync_fetch_and_add(&table.count, 1);
+    __sync_fetch_and_add(&unique_count, 1);
+    res = created;
+    created = 0;
+  }
+
+  pthread_mutex_unlock(lock);
+  mark_crowded(var);
+
+  if (created) bdd_node::release(created);
+  return res;
+}
+
+// records that the subtable of var is over its max load or has overflow
+// nodes, once
+void bdd_tables::mark_crowded(int var)
+{
+  subtable& table = unique_table[var];
+  if (table.crowded || !__sync_bool_compare_and_swap(&table.crowded, 0, 1)) return;
+
+  pthread_mutex_lock(&crowded_lock);
+  crowded_vars.push_back(var);
+  pthread_mutex_unlock(&crowded_lock);
+}
+
+// the computed table can't grow in parallel mode, so it is enlarged
+// beforehand.  the subtables are left alone: a parallel ite is started for
+// every call to ite, so this has to be cheap, and the subtables that fill
+// up are grown by end_parallel
+void bdd_tables::begin_parallel()
+{
+  assert(!concurrent);
+
+  while (computed_table.size() < parallel_computed_size)
+  {
+    grow_computed_table();
+  }
+
+  concurrent = true;
+  bdd_node::set_threaded(true);
+}
+
+// grows the subtables that got too full, and moves the overflow nodes into
+// them
+void bdd_tables::end_parallel()
+{
+  assert(concurrent);
+  concurrent = false;
+  bdd_node::set_threaded(false);
+
+  for (size_t i = 0; i < crowded_vars.size(); ++i)
+  {
+    subtable& table = unique_table[crowded_vars[i]];
+    table.crowded = 0;
+    while (table.count > max_load * table.slots.size())
+    {
+      grow_subtable(table);
+    }
+
+    for (map<child_key, bdd_node*>::iterator node = table.overflow.begin();
+         node != table.overflow.end(); ++node)
+    {
+      // insert_in_subtable counts the node again
+      --table.count;
+      --unique_count;
+      insert_in_subtable(node->second);
+    }
+    table.overflow.clear();
+  }
+  crowded_vars.clear();
+}
+
+void bdd_tables::insert_in_subtable(bdd_node* node)
+{
+  subtable& table = unique_table[node->var];
+  unsigned int mask = table.slots.size() - 1;
+  unsigned int i = unique_hash(node->neg_cf, node->pos_cf) & mask;
+  while (table.slots[i])
+  {
+    i = (i + 1) & mask;
+  }
+  table.slots[i] = node;
+  ++table.count;
+  ++unique_count;
+}
+
+// removes node from its subtable.  the following entries of the probe
+// sequence are shifted back into the hole, so that no lookup stops early
+void bdd_tables::erase_from_subtable(bdd_node* node)
+{
+  subtable& table = unique_table[node->var];
+  unsigned int mask = table.slots.size() - 1;
+  unsigned int i = unique_hash(node->neg_cf, node->pos_cf) & mask;
+  while (table.slots[i] != node)
+  {
+    i = (i + 1) & mask;
+  }
+
+  unsigned int j = i;
+  for (;;)
+  {
+    j = (j + 1) & mask;
+    if (!table.slots[j]) break;
+
+    // the entry at j may fill the hole at i unless its home slot lies
+    // cyclically in (i, j]
+    bdd_node* other = table.slots[j];
+    unsigned int home = unique_hash(other->neg_cf, other->pos_cf) & mask;
+    bool stays = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+    if (!stays)
+    {
+      table.slots[i] = table.slots[j];
+      i = j;
+    }
+  }
+
+  --table.count;
+  --unique_count;
+  table.slots[i] = 0;
+}
+
+// releasing a dead node may leave its children dead, so they are erased
+// as well.  the computed table must not have entries involving any of
+// these nodes (it is empty while reordering, which is where this is used)
+void bdd_tables::erase_dead(bdd_node* node)
+{
+  vector<bdd_node*> stack(1, node);
+  while (!stack.empty())
+  {
+    bdd_node* dead = stack.back();
+    stack.pop_back();
+
+    bdd_node* neg = dead->neg_cf.node();
+    bdd_node* pos = dead->pos_cf.node();
+
+    // releases dead, and with it the references to its children
+    erase_from_subtable(dead);
+    bdd_node::release(dead);
+
+    if (!neg->is_terminal() && neg->get_ref_count() == 0)
+    {
+      stack.push_back(neg);
+    }
+    if (pos != neg && !pos->is_terminal() && pos->get_ref_count() == 0)
+    {
+      stack.push_back(pos);
+    }
+  }
+}
+
+bool bdd_tables::has_dead_node(const computed_entry& entry)
+{
+  size_t edges[4] = { entry.f, entry.g, entry.h, entry.result };
+  for (int i = 0; i < 4; ++i)
+  {
+    if (edges[i] &&
+        reinterpret_cast<bdd_node*>(edges[i] & ~(size_t)1)->get_ref_count() == 0)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+// collection is done in three passes, so that no computed table entry is
+// left pointing at a released node:
+//
+// 1. the subtables are visited top level first.  a dead node gives up its
+//    references to its children, which may leave them dead; since they are
+//    at lower levels, they are found later in the same pass
+// 2. computed table entries involving a node that is now dead are purged
+// 3. the dead nodes are erased from the unique table and released.  their
+//    children's counts were already dropped in pass 1
+unsigned int bdd_tables::collect_garbage()
+{
+  clock_t start = clock();
+  vector<bdd_node*> dead;
+  for (int lvl = 0; lvl < num_vars(); ++lvl)
+  {
+    subtable& table = unique_table[level_to_var[lvl]];
+    for (size_t i = 0; i < table.slots.size(); ++i)
+    {
+      bdd_node* node = table.slots[i];
+      if (node && node->get_ref_count() == 0)
+      {
+        dead.push_back(node);
+        node->neg_cf.node()->decrement_ref_count();
+        node->pos_cf.node()->decrement_ref_count();
+      }
+    }
+  }
+
+  if (dead.empty())
+  {
+    counters.gc_seconds += double(clock() - start) / CLOCKS_PER_SEC;
+    return 0;
+  }
+
+  for (computed_table_t::iterator it = computed_table.begin(); it != computed_table.end(); ++it)
+  {
+    if (it->op >= 0 && has_dead_node(*it))
+    {
+      *it = computed_entry();
+      --computed_count;
+    }
+  }
+
+  for (vector<bdd_node*>::iterator it = dead.begin(); it != dead.end(); ++it)
+  {
+    bdd_node* node = *it;
+    erase_from_subtable(node);
+
+    // the references were dropped above
+    node->neg_cf.bits = 0;
+    node->pos_cf.bits = 0;
+    bdd_node::release(node);
+  }
+
+  ++counters.gc_runs;
+  counters.gc_released += dead.size();
+  counters.gc_seconds += double(clock() - start) / CLOCKS_PER_SEC;
+  return dead.size();
+}
+
+// the edge bits with the node moved to its new slot, if it is moved.
+// new_id is indexed by the old ids, and is -1 for the nodes that stay
+static size_t relocated(size_t bits, const vector<int>& new_id, const bdd_allocator& allocator)
+{
+  if (!bits) return 0;
+  int id = new_id[reinterpret_cast<bdd_node*>(bits & ~(size_t)1)->get_id()];
+  if (id < 0) return bits;
+  return reinterpret_cast<size_t>(allocator.slot(id)) | (bits & 1);
+}
 
-  unique_table[unique_table_key(var, left->get_id(), right->get_id())] = new_node;
+// orders nodes top level first
+struct by_level
+{
+  by_level(const bdd_tables& tables_in) : tables(tables_in) {}
+
+  bool operator() (bdd_node* a, bdd_node* b) const
+  {
+    return tables.level(a->var) < tables.level(b->var);
+  }
+
+  const bdd_tables& tables;
+};
+
+// a node of compact(), as it will be written
+struct compacted_node
+{
+  int var;
+  size_t neg, pos;
+  unsigned int ref_count;
+};
+
+// the new slots and edges are all worked out before any node is written
+// over, since a node's new slot may hold another node that is still to
+// be moved
+bdd_tables::compact_stats bdd_tables::compact()
+{
+  assert(op_depth == 0 && !concurrent);
+  collect_garbage();
+
+  bdd_allocator& allocator = bdd_node::allocator();
+  int owner = bdd_node::one().node()->store_index;
+  compact_stats stats;
+  stats.slots_before = allocator.capacity();
+
+  // the nodes, top level first, and the references they get from parents
+  vector<bdd_node*> nodes;
+  for (int lvl = 0; lvl < num_vars(); ++lvl)
+  {
+    subtable& table = unique_table[level_to_var[lvl]];
+    for (size_t i = 0; i < table.slots.size(); ++i)
+    {
+      if (table.slots[i]) nodes.push_back(table.slots[i]);
+    }
+  }
+  vector<unsigned int> parent_refs(stats.slots_before, 0);
+  for (size_t i = 0; i < nodes.size(); ++i)
+  {
+    ++parent_refs[nodes[i]->neg_cf.node()->get_id()];
+    ++parent_refs[nodes[i]->pos_cf.node()->get_id()];
+  }
+
+  // the nodes that stay, then the others breadth first from them
+  vector<bool> used(stats.slots_before, false);
+  used[bdd_node::one().get_id()] = true;
+  vector<bdd_node*> order;
+  for (size_t i = 0; i < nodes.size(); ++i)
+  {
+    if (nodes[i]->get_ref_count() > parent_refs[nodes[i]->get_id()])
+    {
+      used[nodes[i]->get_id()] = true;
+      order.push_back(nodes[i]);
+    }
+  }
+  size_t pinned = order.size();
+  vector<bool> seen(used);
+  for (size_t head = 0; head < order.size(); ++head)
+  {
+    bdd_node* children[2] = { order[head]->neg_cf.node(), order[head]->pos_cf.node() };
+    for (int c = 0; c < 2; ++c)
+    {
+      if (!seen[children[c]->get_id()])
+      {
+        seen[children[c]->get_id()] = true;
+        order.push_back(children[c]);
+      }
+    }
+  }
+  // every node is a descendant of one that the program refers to
+  assert(order.size() == nodes.size());
+  stable_sort(order.begin() + pinned, order.end(), by_level(*this));
+
+  vector<int> new_id(stats.slots_before, -1);
+  int next = 0;
+  for (size_t i = pinned; i < order.size(); ++i)
+  {
+    while (used[next]) ++next;
+    new_id[order[i]->get_id()] = next;
+    used[next] = true;
+  }
+
+  vector<compacted_node> moved(order.size());
+  for (size_t i = 0; i < order.size(); ++i)
+  {
+    moved[i].var = order[i]->var;
+    moved[i].neg = relocated(order[i]->neg_cf.bits, new_id, allocator);
+    moved[i].pos = relocated(order[i]->pos_cf.bits, new_id, allocator);
+    moved[i].ref_count = order[i]->get_ref_count();
+  }
+
+  vector<computed_entry> entries;
+  for (computed_table_t::iterator it = computed_table.begin(); it != computed_table.end(); ++it)
+  {
+    if (it->op < 0) continue;
+    computed_entry entry;
+    entry.op = it->op;
+    entry.f = relocated(it->f, new_id, allocator);
+    entry.g = relocated(it->g, new_id, allocator);
+    entry.h = relocated(it->h, new_id, allocator);
+    entry.result = relocated(it->result, new_id, allocator);
+    entries.push_back(entry);
+  }
+
+  // write the nodes.  the ones that stay only get their new children
+  for (size_t i = 0; i < order.size(); ++i)
+  {
+    bdd_node* node = order[i];
+    if (i >= pinned)
+    {
+      int id = new_id[node->get_id()];
+      node = new (allocator.slot(id)) bdd_node(id, owner);
+      node->var = moved[i].var;
+      node->ref_count = moved[i].ref_count;
+      order[i] = node;
+    }
+    node->neg_cf.bits = moved[i].neg;
+    node->pos_cf.bits = moved[i].pos;
+  }
+  stats.nodes = order.size();
+  stats.moved = order.size() - pinned;
+  allocator.reset_free_list(used);
+  stats.slots_after = allocator.capacity();
+
+  // the hashes of both tables are of the new ids
+  for (unique_table_t::iterator it = unique_table.begin(); it != unique_table.end(); ++it)
+  {
+    unsigned int size = initial_subtable_size;
+    while (it->count > max_load * size) size *= 2;
+    it->slots.assign(size, (bdd_node*)0);
+    it->count = 0;
+  }
+  unique_count = 0;
+  for (size_t i = 0; i < order.size(); ++i)
+  {
+    insert_in_subtable(order[i]);
+  }
+
+  computed_table.assign(computed_table.size(), computed_entry());
+  computed_count = 0;
+  unsigned int mask = computed_table.size() - 1;
+  for (size_t i = 0; i < entries.size(); ++i)
+  {
+    computed_entry& entry = computed_table[computed_hash(entries[i].op, entries[i].f, entries[i].g,
+                                                         entries[i].h) & mask];
+    if (entry.op < 0) ++computed_count;
+    entry = entries[i];
+  }
+
+  return stats;
+}
+
+void bdd_tables::clear()
+{
+  clear_computed_table();
+  collect_garbage();
+  for (unique_table_t::iterator it = unique_table.begin(); it != unique_table.end(); ++it)
+  {
+    if (it->count == 0)
+    {
+      it->slots.assign(initial_subtable_size, (bdd_node*)0);
+    }
+  }
+}
+
+// returns the canonical edge for var' left + var right.  a node whose
+// children are equal is redundant, so the child itself is returned.
+// otherwise, if right is complemented, the node is built for the
+// complemented children instead and a complemented edge to it is returned
+bdd_ptr bdd_tables::get_node(int var, bdd_ptr left, bdd_ptr right)
+{
+  if (left == right)
+  {
+    return left;
+  }
+
+  bool comp = right.is_complemented();
+  if (comp)
+  {
+    left = left.complement();
+    right = right.complement();
+  }
+
+  if (concurrent)
+  {
+    bdd_ptr res = find_or_add_concurrent(var, left, right);
+    return comp ? res.complement() : res;
+  }
+
+  bdd_ptr res = find_in_unique_table(var, left, right);
+  if (!res)
+  {
+    res = create_and_add_to_unique_table(var, left, right);
+  }
+  return comp ? res.complement() : res;
+}
+
+// the ZDD node var' left + var right.  ZDDs don't use complemented edges,
+// except for the edges to zero, so right is regular
+bdd_ptr bdd_tables::get_zdd_node(int var, const bdd_ptr& left, const bdd_ptr& right)
+{
+  if (right.is_zero())
+  {
+    return left;
+  }
+  if (concurrent)
+  {
+    return find_or_add_concurrent(var, left, right);
+  }
+
+  bdd_ptr res = find_in_unique_table(var, left, right);
+  if (!res)
+  {
+    res = create_and_add_to_unique_table(var, left, right);
+  }
+  return res;
+}
+
+// returns the var named name, creating it at the bottom level if needed
+int bdd_tables::add_var(const string& name)
+{
+  int var = find_var(name);
+  if (var >= 0)
+  {
+    return var;
+  }
+
+  var = var_names.size();
+  var_names.push_back(name);
+  var_ids[name] = var;
+  var_to_level.push_back(var);
+  level_to_var.push_back(var);
+  zdd_vars.push_back(false);
+  literal_vars.push_back(-1);
+  literal_vars.push_back(-1);
+  literal_sources.push_back(-1);
+  unique_table.push_back(subtable());
+  return var;
+}
+
+int bdd_tables::add_zdd_var(const string& name)
+{
+  int var = find_var(name);
+  if (var >= 0)
+  {
+    return zdd_vars[var] ? var : -1;
+  }
 
+  var = add_var(name);
+  zdd_vars[var] = true;
+  return var;
+}
 
-  return new_node;
+int bdd_tables::literal_var(int var, bool positive)
+{
+  int& lit = literal_vars[2 * var + (positive ? 1 : 0)];
+  if (lit < 0)
+  {
+    // a BDD var may have taken the name, then the name gets primes
+    string name = var_names[var] + (positive ? "+" : "-");
+    int zdd_var;
+    while ((zdd_var = add_zdd_var(name)) < 0)
+    {
+      name += "'";
+    }
+
+    // add_var may have moved literal_vars
+    literal_vars[2 * var + (positive ? 1 : 0)] = zdd_var;
+    literal_sources[zdd_var] = 2 * var + (positive ? 1 : 0);
+    return zdd_var;
+  }
+  return lit;
+}
+
+int bdd_tables::literal_source(int lit, bool& positive) const
+{
+  int source = literal_sources[lit];
+  positive = (source & 1) != 0;
+  return (source < 0) ? -1 : source >> 1;
+}
+
+int bdd_tables::find_var(const string& name) const
+{
+  map<string, int>::const_iterator it = var_ids.find(name);
+  return (it != var_ids.end()) ? it->second : -1;
+}
+
+// doubles a subtable and rehashes its nodes into it
+void bdd_tables::grow_subtable(subtable& table)
+{
+  vector<bdd_node*> old_slots(2 * table.slots.size(), (bdd_node*)0);
+  old_slots.swap(table.slots);
+
+  unsigned int mask = table.slots.size() - 1;
+  for (vector<bdd_node*>::iterator it = old_slots.begin(); it != old_slots.end(); ++it)
+  {
+    if (!*it) continue;
+    bdd_node* node = *it;
+
+    unsigned int i = unique_hash(node->neg_cf, node->pos_cf) & mask;
+    while (table.slots[i])
+    {
+      i = (i + 1) & mask;
+    }
+    table.slots[i] = node;
+  }
+}
+
+// in the table dumps, an edge is shown as the id of its node, preceded by
+// a ! if the edge is complemented.  edges are passed around as edge_keys
+static string edge_str(unsigned int key)
+{
+  if (key == no_edge) return "-";
+
+  ostringstream os;
+  os << ((key & 1) ? "!" : "") << (key >> 1);
+  return os.str();
 }
 
 ostream& operator<<(ostream& os, const computed_table_key& ctk)
 {
-  os << "{" << setw(3) << ctk.op << ", ";
-  os << setw(3) << ctk.lhs << ", ";
-  os << setw(3) << ctk.rhs << "}";
+  os << "{" << setw(3) << computed_op_name(ctk.op) << ", ";
+  os << setw(4) << edge_str(ctk.f) << ", ";
+  os << setw(4) << edge_str(ctk.g) << ", ";
+  os << setw(4) << edge_str(ctk.h) << "}";
   return os;
 }
 
+void bdd_tables::set_truth_table_threshold(int levels)
+{
+  truth_table_levels = max(0, min(levels, max_truth_table_vars));
+}
+
+bdd_tables::table_stats::table_stats() :
+  unique_lookups(0), unique_hits(0), unique_collisions(0),
+  nodes_created(0), peak_nodes(0),
+  gc_runs(0), gc_released(0), gc_seconds(0),
+  memory_bytes(0), seconds(0)
+{
+  for (int op = 0; op < NUM_COMPUTED_OPS; ++op)
+  {
+    computed_lookups[op] = 0;
+    computed_hits[op] = 0;
+  }
+}
+
+unsigned long bdd_tables::computed_lookup_count() const
+{
+  unsigned long lookups = 0;
+  for (int op = 0; op < NUM_COMPUTED_OPS; ++op) lookups += counters.computed_lookups[op];
+  return lookups;
+}
+
+unsigned long bdd_tables::computed_hit_count() const
+{
+  unsigned long hits = 0;
+  for (int op = 0; op < NUM_COMPUTED_OPS; ++op) hits += counters.computed_hits[op];
+  return hits;
+}
+
+bdd_tables::table_stats bdd_tables::stats() const
+{
+  table_stats s = counters;
+  if (unique_count > s.peak_nodes) s.peak_nodes = unique_count;
+
+  s.memory_bytes = bdd_node::live_count() * sizeof(bdd_node) +
+                   computed_table.size() * sizeof(computed_entry) +
+                   unique_table.size() * sizeof(subtable);
+  for (unique_table_t::const_iterator it = unique_table.begin(); it != unique_table.end(); ++it)
+  {
+    s.memory_bytes += it->slots.size() * sizeof(bdd_node*);
+  }
+  s.seconds = double(clock() - stats_start) / CLOCKS_PER_SEC;
+  return s;
+}
+
+void bdd_tables::reset_stats()
+{
+  counters = table_stats();
+  counters.peak_nodes = unique_count;
+  stats_start = clock();
+}
+
+// a percentage of n out of total, or - if total is 0
+static string percent(unsigned long n, unsigned long total)
+{
+  if (total == 0) return "-";
+  ostringstream os;
+  os << setprecision(3) << 100.0 * n / total << "%";
+  return os.str();
+}
+
+// for example
+//   nodes 1200 (peak 5000, 310000/s), 180 kB | unique 9000 lookups, 41% hits,
+//   0.2 collisions | computed 15000 lookups, 37% hits (ite 35%, cof 60%) |
+//   gc 2 runs, 4000 nodes, 0.001 s
+void bdd_tables::print_stats(ostream& os) const
+{
+  table_stats s = stats();
+  streamsize precision = os.precision(3);
+
+  os << "nodes " << unique_count << " (peak " << s.peak_nodes << ", "
+     << (unsigned long)(s.seconds > 0 ? s.nodes_created / s.seconds : 0) << "/s), "
+     << (s.memory_bytes + 1023) / 1024 << " kB";
+
+  os << " | unique " << s.unique_lookups << " lookups, "
+     << percent(s.unique_hits, s.unique_lookups) << " hits, "
+     << (s.unique_lookups ? double(s.unique_collisions) / s.unique_lookups : 0.0)
+     << " collisions";
+
+  unsigned long lookups = computed_lookup_count();
+  os << " | computed " << lookups << " lookups, " << percent(computed_hit_count(), lookups)
+     << " hits";
+  const char* sep = " (";
+  for (int op = 0; op < NUM_COMPUTED_OPS; ++op)
+  {
+    if (s.computed_lookups[op] == 0) continue;
+    os << sep << computed_op_name(op) << " " << percent(s.computed_hits[op], s.computed_lookups[op]);
+    sep = ", ";
+  }
+  if (lookups) os << ")";
+
+  os << " | gc " << s.gc_runs << " runs, " << s.gc_released << " nodes, " << s.gc_seconds
+     << " s" << endl;
+  os.precision(precision);
+}
+
+// the tables are printed in key order, like the std::map based tables were
 void bdd_tables::print_computed_table()
 {
-  computed_table_t::iterator it = computed_table.begin();
-  computed_table_t::iterator end = computed_table.end();
+  vector<pair<computed_table_key, unsigned int> > entries;
+  for (computed_table_t::iterator it = computed_table.begin(); it != computed_table.end(); ++it)
+  {
+    if (it->op < 0) continue;
+    entries.push_back(make_pair(computed_table_key(it->op, edge_key(it->f), edge_key(it->g),
+                                                   edge_key(it->h)),
+                                edge_key(it->result)));
+  }
+  sort(entries.begin(), entries.end());
 
   cout << "computed_table:" << endl;
 
-  for (; it != end; ++it)
+  for (size_t i = 0; i < entries.size(); ++i)
   {
-    cout << it->first << "  -->  " << it->second->get_id() << endl;
+    cout << entries[i].first << "  -->  " << edge_str(entries[i].second) << endl;
   }
 }
 
 ostream& operator<<(ostream& os, const unique_table_key& utk)
 {
-  os << "{" << utk.var << ", ";
-  os << setw(3) << utk.neg_cf_id << ", ";
-  os << setw(3) << utk.pos_cf_id << "}";
+  os << "{" << bdd_tables::getInstance().var_name(utk.var) << ", ";
+  os << setw(4) << edge_str((utk.neg_cf_id << 1) | (utk.neg_comp ? 1 : 0)) << ", ";
+  os << setw(4) << utk.pos_cf_id << "}";
   return os;
 }
 
 void bdd_tables::print_unique_table()
 {
-  unique_table_t::iterator it = unique_table.begin();
-  unique_table_t::iterator end = unique_table.end();
+  vector<pair<unique_table_key, int> > entries;
+  for (unique_table_t::iterator table = unique_table.begin(); table != unique_table.end(); ++table)
+  {
+    for (vector<bdd_node*>::iterator it = table->slots.begin(); it != table->slots.end(); ++it)
+    {
+      if (!*it) continue;
+      bdd_node* node = *it;
+      entries.push_back(make_pair(unique_table_key(node->var, node->neg_cf.get_id(), node->pos_cf.get_id(),
+                                                   node->neg_cf.is_complemented()),
+                                  node->get_id()));
+    }
+  }
+  sort(entries.begin(), entries.end());
 
   cout << "unique_table:" << endl;
-  
-  for (; it != end; ++it)
+
+  for (size_t i = 0; i < entries.size(); ++i)
   {
-    cout << it->first << "  -->  " << it->second->get_id() << endl;
+    cout << entries[i].first << "  -->  " << entries[i].second << endl;
   }
 }
-
-
-
@@ -10,107 +10,598 @@
  *  - use of smart pointers
  *  - made bdd_tables a singleton
  *  - computed table now considers operation
- * 
+ *
+ * Modified to replace the std::map tables with an open addressing
+ * unique table and a direct mapped, lossy computed cache
+ *
+ * Modified for complemented edges
+ *  - added get_node, which keeps the then edge regular
+ *
+ * Modified for ite
+ *  - computed table entries have up to three operands
+ *
+ * Modified for integer variables
+ *  - vars are ints, with names and a var <-> level order table
+ *
+ * Modified for dynamic variable reordering
+ *  - the unique table is split into one subtable per var
+ *  - added swap_levels and sifting (see bdd_reorder.cpp)
+ *
+ * Modified for garbage collection
+ *  - the tables no longer hold references to nodes
+ *  - dead nodes are released in batches by collect_garbage
+ *
+ * Modified for parallel operations
+ *  - get_node and the computed table may be used by several threads
+ *    between begin_parallel and end_parallel
+ *
+ * Modified for bdd_managers
+ *  - every bdd_manager owns a bdd_tables; getInstance returns the one of
+ *    the current manager
+ *
+ * Modified for ZDDs
+ *  - ZDD vars, which sifting leaves in place, and get_zdd_node
+ *
+ * Modified for instrumentation
+ *  - table_stats counts the work of both tables and the collector
+ *
  * Defines the class Bdd_tables, along with a structs computed_table_key
  * and unique_table_key
  */
 
+#include <vector>
 #include <map>
-#include <set>
+#include <string>
+#include <iostream>
+#include <climits>
+#include <ctime>
+#include <pthread.h>
 #include "bdd_node.h"
 
+// the operations whose results are kept in the computed table.  every
+// boolean operation is computed as an ite, so they all share CT_ITE entries.
+// CT_COFACTOR entries are <f, cube> -> the cofactor of f w.r.t. cube, and
+// CT_AND_EXISTS entries are <f, g, cube> -> the vars of cube quantified
+// existentially out of f g (with g = 1 for plain quantification),
+// CT_SUPPORT entries are <node> -> the cube of the vars it depends on, and
+// CT_COMPOSE entries are <node, g, var> -> the node with g for var.
+// the rest are the operations of bdd_zdd.h: CT_ZDD_CHANGE entries are
+// <P, {{var}}> -> P with var toggled, CT_ISOP and CT_ISOP_BDD entries are
+// <L, U> -> the cover found for L <= U and its BDD, and CT_COVER_BDD
+// entries are <P> -> the BDD of the cover P
+enum computed_op
+{
+  CT_ITE,
+  CT_COFACTOR,
+  CT_AND_EXISTS,
+  CT_SUPPORT,
+  CT_COMPOSE,
+  CT_ZDD_UNION,
+  CT_ZDD_INTERSECT,
+  CT_ZDD_DIFF,
+  CT_ZDD_PRODUCT,
+  CT_ZDD_CHANGE,
+  CT_ISOP,
+  CT_ISOP_BDD,
+  CT_COVER_BDD,
+  NUM_COMPUTED_OPS
+};
+
+// the name of a computed_op, for printing
+const char* computed_op_name(int op);
+
 // a computed table entry is uniquely identified by the operation,
-// and the is of the two nodes it was performed on
+// and the edges it was performed on (node id * 2, plus one if the
+// edge is complemented)
 struct computed_table_key
 {
-  computed_table_key(std::string op_in, int lhs_in, int rhs_in = 0) :
-    op(op_in), lhs(lhs_in), rhs(rhs_in)
+  computed_table_key(int op_in, unsigned int f_in, unsigned int g_in = 0, unsigned int h_in = 0) :
+    op(op_in), f(f_in), g(g_in), h(h_in)
   {}
 
   bool operator< (const computed_table_key& rhs) const;
 
-  std::string op;
-  int lhs;
-  int rhs;
+  int op;
+  unsigned int f;
+  unsigned int g;
+  unsigned int h;
 };
 
 
 // a unique table entry is uniquely identified by the splitting variable
-// of the node, and the ids of its two children
+// of the node, the ids of its two children and whether the negative child
+// is reached through a complemented edge
 struct unique_table_key
 {
-  unique_table_key(char var_in, int neg_in, int pos_in) :
-  var(var_in), neg_cf_id(neg_in), pos_cf_id(pos_in)
+  unique_table_key(int var_in, int neg_in, int pos_in, bool neg_comp_in = false) :
+  var(var_in), neg_cf_id(neg_in), pos_cf_id(pos_in), neg_comp(neg_comp_in)
   {}
 
   bool operator< (const unique_table_key& rhs) const;
 
-  char var;
+  int var;
   int neg_cf_id;
   int pos_cf_id;
+  bool neg_comp;
 };
 
 // bdd_tables handles the bookkeeping of the apply function.  It maintains two
 // tables.
 //
-// computed_table keeps track of all of the results of calling apply on two
-// bdd_nodes.  This way, you can check to see if a result already exists by
+// computed_table keeps track of the results of calling ite (or another
+// computed_op) on up to three bdd_nodes.  This way, you can check to see if a result already exists by
 // calling find_in_computed_table.  When a result is found, you should add
-// it to the computed table by calling insert_in_computed_table
-// 
+// it to the computed table by calling insert_in_computed_table.  The computed
+// table is a cache: each key maps to exactly one slot, and a new result
+// simply overwrites whatever was stored there, so a lookup may miss a result
+// that was computed earlier.
+//
 // unique_table keeps track of the nodes that make up the new BDD that will
 // be the result of the apply function.  once you have a result for a var
-// and two Bdd_nodes (one from the first BDD, another for the 2nd BDD), 
+// and two Bdd_nodes (one from the first BDD, another for the 2nd BDD),
 // you can check to see if this result already exists by calling
 // find_in_unique_table.  If it doesn't exist, you can create the new node
-// and add it the the unique table all by calling create_and_add_to_unique_table
+// and add it the the unique table all by calling create_and_add_to_unique_table.
+// get_node does all of this, and also takes care of the reduction rule and of
+// keeping pos_cf a regular edge, so it is the usual way to make a node.
+//
+// bdd_tables also keeps the variables.  A var is an int (0, 1, 2, ...)
+// with a name, and is split on at a certain level: nodes for vars at
+// lower levels are closer to the root.  A var is added at the bottom
+// level, so by default vars are ordered by when they were first seen.
+//
+// The unique table is made of one subtable per var, holding the nodes that
+// split on that var.  Each subtable and the computed table is a flat array
+// whose size is a power of two, indexed by a hash of the key.  Subtables
+// resolve collisions by linear probing and double once they are more than
+// max_load full.  The computed table doubles (up to max_computed_size) under
+// the same condition, carrying over the entries that still fit.
+//
+// The order of the vars can be changed while nodes exist, by swapping
+// adjacent levels in place (swap_levels).  reorder() uses this to sift
+// every var to the level where the BDDs are smallest.  Nodes keep their
+// identity and function when levels are swapped, so every bdd_ptr stays
+// valid.  If reordering is enabled (it is off until set_reordering(true),
+// so the order the vars were added in is kept), it happens automatically
+// when an operation starts and the unique table holds more than the
+// reorder threshold nodes.
+//
+// Reordering can't happen in the middle of an operation, since operations
+// split on vars in level order.  Every operation that calls get_node
+// therefore creates a bdd_op_scope (see below) on entry; reordering is only
+// started when the outermost scope is entered.
+//
+// Neither table counts as a reference to the nodes in it.  A node that the
+// program and its parents no longer refer to is dead (see bdd_node.h) but
+// stays in the unique table, where get_node may find it and bring it back to
+// life.  collect_garbage releases the dead nodes and purges them from both
+// tables.  Releasing a node may leave its children dead, so the collector goes
+// through the subtables top level first, and a node is released after all of
+// its parents.  Like reordering, garbage collection happens when the
+// outermost bdd_op_scope is entered, once the dead nodes make up more than
+// the gc fraction of the unique table.
+//
+// Between begin_parallel() and end_parallel(), several threads may call
+// get_node and use the computed table at the same time (see bdd_parallel.h);
+// nothing else may be called, and there is no garbage collection or
+// reordering.  In this mode:
+//  - a node is put into a subtable by a compare-and-swap on an empty slot,
+//    and a thread that loses the race for the slot looks again at what was
+//    put there.  subtables can't grow, so once a probe has looked at
+//    max_probe slots without finding the node or an empty one, the node
+//    goes into the subtable's overflow map, which is protected by a lock.
+//    nodes inserted outside of this mode may lie beyond max_probe slots, so
+//    the probe first reads on to the first empty slot.  slots are never
+//    emptied in this mode, so a node that isn't in the slots before it can
+//    only be in the overflow map, and every node is still created exactly
+//    once.  end_parallel() grows the subtables that got too
+//    full and moves the overflow nodes back into them
+//  - each computed table entry has a version that is odd while the entry is
+//    being written.  a writer that can't make it odd leaves the entry alone,
+//    and a reader ignores the entry if the version was odd or changed while
+//    reading it.  so entries may be lost, but are never seen half written
+//  - the computed table doesn't grow either; begin_parallel() enlarges it
+//    beforehand
 class bdd_tables
 {
 public:
 
-  // Meyers Singleton Accessor: the way to get access to the one and 
-  // only bdd_tables instance
+  // the tables of the calling thread's current manager (see
+  // bdd_manager.h)
   static bdd_tables& getInstance();
-  
-  bdd_ptr find_in_computed_table(const std::string& op, bdd_ptr bdd1, bdd_ptr bdd2);
 
-  void insert_computed_table(const std::string& op, bdd_ptr bdd1, bdd_ptr bdd2, bdd_ptr computed_node);
+  // operands that an operation doesn't use are left null
+  bdd_ptr find_in_computed_table(int op, const bdd_ptr& f, const bdd_ptr& g,
+                                 const bdd_ptr& h = bdd_ptr());
+
+  void insert_computed_table(int op, const bdd_ptr& f, const bdd_ptr& g,
+                             const bdd_ptr& h, const bdd_ptr& computed_node);
+
+  bdd_ptr find_in_unique_table(int var, bdd_ptr left, bdd_ptr right);
+  bdd_ptr create_and_add_to_unique_table(int var, bdd_ptr left, bdd_ptr right);
+
+  // returns the canonical edge for the function var' left + var right,
+  // creating a node if necessary
+  bdd_ptr get_node(int var, bdd_ptr left, bdd_ptr right);
+
+  // returns the ZDD node of the family left + var right (the sets of left,
+  // and those of right with var added; see bdd_zdd.h), creating it if
+  // necessary.  the zero-suppression rule applies instead of the reduction
+  // rule: the node is left if right is empty (zero)
+  bdd_ptr get_zdd_node(int var, const bdd_ptr& left, const bdd_ptr& right);
+
+  // variable management
+
+  // returns the var with the given name, adding it (at the bottom level)
+  // if it doesn't exist yet
+  int add_var(const std::string& name);
+
+  // returns the var with the given name, or -1 if there is none
+  int find_var(const std::string& name) const;
 
-  bdd_ptr find_in_unique_table(char var, bdd_ptr left, bdd_ptr right);
-  bdd_ptr create_and_add_to_unique_table(char var, bdd_ptr left, bdd_ptr right);
+  // ZDD vars are the elements of the sets of ZDDs.  they are kept apart
+  // from the vars of BDDs, and reordering never changes their relative
+  // order: sifting skips them, and set_var_order refuses an order that
+  // would swap two of them.  add_zdd_var returns the ZDD var with the
+  // given name, adding it at the bottom level if needed, or -1 if a BDD
+  // var has that name
+  int add_zdd_var(const std::string& name);
+  bool is_zdd_var(int var) const { return zdd_vars[var]; }
 
-  void clear_computed_table()
+  // the ZDD var of the literal var (positive) or var' (negative) in covers
+  // (see bdd_zdd.h), named var+ or var-.  added if it doesn't exist yet
+  int literal_var(int var, bool positive);
+
+  // the var whose literal the ZDD var lit is, and which literal, or -1 if
+  // lit is no literal
+  int literal_source(int lit, bool& positive) const;
+
+  const std::string& var_name(int var) const { return var_names[var]; }
+
+  int num_vars() const { return var_names.size(); }
+
+  // the level var is split on, and the var at a level
+  int level(int var) const { return var_to_level[var]; }
+  int var_at_level(int lvl) const { return level_to_var[lvl]; }
+
+  // the level of the top var of f.  terminals are below every var
+  int top_level(const bdd_ptr& f) const
   {
-    computed_table.clear();
+    return f.is_terminal() ? terminal_level : var_to_level[f.var()];
   }
-  
-  // clear all entries
-  void clear()
+
+  // the BDD of the function that is just var
+  bdd_ptr var_bdd(int var) { return get_node(var, bdd_node::zero(), bdd_node::one()); }
+
+  // sets the order of the vars: order[l] is the var at level l, and must be
+  // a permutation of all vars that keeps the ZDD vars in their order.
+  // returns false (and changes nothing) if it isn't.  existing nodes are
+  // moved by swapping levels
+  bool set_var_order(const std::vector<int>& order);
+
+  static const int terminal_level = INT_MAX;
+
+  // dynamic variable reordering
+
+  // what a call to reorder() did
+  struct reorder_stats
+  {
+    reorder_stats() : nodes_before(0), nodes_after(0), swaps(0), seconds(0) {}
+
+    unsigned int nodes_before;
+    unsigned int nodes_after;
+    unsigned int swaps;
+    double seconds;
+  };
+
+  // sifts every var (largest subtables first) to its best level, and
+  // returns the node counts before and after
+  reorder_stats reorder();
+
+  // exchanges the vars at levels lvl and lvl + 1, and returns the number
+  // of nodes afterwards
+  unsigned int swap_levels(int lvl);
+
+  // releases every dead node, and removes it from the unique table along
+  // with the computed table entries that involve it.  returns the number
+  // of nodes released
+  unsigned int collect_garbage();
+
+  // what a call to compact() did
+  struct compact_stats
+  {
+    compact_stats() : nodes(0), moved(0), slots_before(0), slots_after(0) {}
+
+    unsigned int nodes;        // live nodes, the terminal aside
+    unsigned int moved;
+    unsigned int slots_before; // slots in the allocator's chunks
+    unsigned int slots_after;
+  };
+
+  // collects all garbage, and then moves the nodes into the lowest slots
+  // of the allocator, in level order, so that traversals go through memory
+  // mostly in order.  the nodes the program refers to (and not just their
+  // parents) can't be moved; the others are numbered breadth first from
+  // them, and sorted by level.  the children of every node and the
+  // computed table entries are redirected to the new slots, the subtables
+  // are rebuilt at the sizes they need and the chunks that are left empty
+  // are freed.  must not be called during an operation
+  compact_stats compact();
+
+  // garbage collection settings.  collection starts once more than
+  // fraction of the nodes in the unique table are dead (and there are at
+  // least min_gc_dead of them).  0 collects whenever there is garbage
+  void set_gc_fraction(double fraction) { gc_fraction = fraction; }
+
+  // number of nodes in the unique table that are dead
+  unsigned int dead_count() const { return bdd_node::dead_count(); }
+
+  // number of garbage collections so far, and nodes released by them
+  unsigned int gc_runs() const { return counters.gc_runs; }
+  unsigned int gc_released() const { return counters.gc_released; }
+
+  // reordering settings.  while sifting a var, it isn't moved further in
+  // one direction once the BDDs have grown more than max_growth times
+  // their smallest size; no var is sifted after time_limit seconds
+  void set_reordering(bool enable) { reordering = enable; }
+  bool reordering_enabled() const { return reordering; }
+  void set_reorder_threshold(unsigned int nodes) { reorder_threshold = next_reorder = nodes; }
+  void set_max_growth(double growth) { max_growth = growth; }
+  void set_reorder_time_limit(double seconds) { reorder_time_limit = seconds; }
+
+  // the number of levels of the truth table path of apply (see
+  // bdd_truth_table.h), at most max_truth_table_vars.  0 turns it off
+  void set_truth_table_threshold(int levels);
+  int truth_table_threshold() const { return truth_table_levels; }
+
+  // whether automatic reorderings are reported on cout
+  void set_reorder_verbose(bool verbose) { reorder_verbose = verbose; }
+
+  // the result of the last reordering
+  const reorder_stats& last_reorder() const { return last_reorder_stats; }
+
+  // called by bdd_op_scope
+  void enter_op()
   {
-    clear_computed_table();
-    unique_table.clear();
+    if (op_depth == 0)
+    {
+      if (dead_count() >= min_gc_dead && dead_count() > gc_fraction * unique_count)
+      {
+        collect_garbage();
+      }
+      if (reordering && unique_count > next_reorder)
+      {
+        auto_reorder();
+      }
+    }
+    ++op_depth;
   }
+  void leave_op() { --op_depth; }
+
+  void clear_computed_table();
+
+  // clear the computed table and collect all garbage.  the unique table
+  // keeps the nodes that are still referred to
+  void clear();
+
+  // number of nodes in the unique table, dead ones included
+  unsigned int unique_table_size() const { return unique_count; }
+
+  // number of computed table lookups so far, and how many found a result.
+  // lookups in parallel mode aren't counted
+  unsigned long computed_lookup_count() const;
+  unsigned long computed_hit_count() const;
+
+  // what the tables have done since they were made or reset_stats was
+  // last called, for tuning the table sizes.  lookups in parallel mode
+  // aren't counted, nor are the nodes made then
+  struct table_stats
+  {
+    table_stats();
+
+    // unique table lookups, how many found the node, and the slots they
+    // probed that held other nodes
+    unsigned long unique_lookups;
+    unsigned long unique_hits;
+    unsigned long unique_collisions;
+
+    // nodes added to the unique table, and the most it has held
+    unsigned long nodes_created;
+    unsigned int peak_nodes;
+
+    // computed table lookups and hits per computed_op
+    unsigned long computed_lookups[NUM_COMPUTED_OPS];
+    unsigned long computed_hits[NUM_COMPUTED_OPS];
+
+    unsigned int gc_runs;
+    unsigned long gc_released;
+    double gc_seconds;
+
+    // filled in by stats(): the bytes taken by the nodes and the tables
+    // now, and the processor time since the counters were reset
+    size_t memory_bytes;
+    double seconds;
+  };
+
+  table_stats stats() const;
+  void reset_stats();
+
+  // prints the stats on one line
+  void print_stats(std::ostream& os) const;
+
+  // number of nodes in the unique table that split on var
+  unsigned int subtable_size(int var) const { return unique_table[var].count; }
+
+  // parallel operations (see above)
+  void begin_parallel();
+  void end_parallel();
+  bool in_parallel() const { return concurrent; }
 
   void print_computed_table();
   void print_unique_table();
 
+  // table sizing
+  static const unsigned int initial_subtable_size = 64;
+  static const unsigned int initial_computed_size = 1024;
+  static const unsigned int max_computed_size = 1 << 22;
+
+  // a table is grown once count / size exceeds max_load
+  static const double max_load;
+
+  // fewer dead nodes than this aren't worth a garbage collection
+  static const unsigned int min_gc_dead = 1024;
+
+  // in parallel mode, the number of slots a probe looks at before it goes
+  // to the overflow map, and the size the computed table is enlarged to
+  static const unsigned int max_probe = 32;
+  static const unsigned int parallel_computed_size = 1 << 18;
+
 private:
-  // only construction should be in GetInstance()
-  bdd_tables() {}
-  
+  // only a bdd_manager makes tables
+  friend class bdd_manager;
+  bdd_tables();
+  ~bdd_tables();
+
   // dissallow copy and assignment
   bdd_tables(const bdd_tables&);
   bdd_tables& operator=(const bdd_tables&);
-  
-  // <operation, node id from Bdd1, node id from Bdd2> -> <resulting node>
-  typedef std::map<computed_table_key, bdd_ptr> computed_table_t;
-  
+
+  // <operation, f, g, h> -> <resulting node>
+  // the edges are kept as the raw bits of a bdd_ptr (0 for an unused
+  // operand), which don't count as references.  an entry is purged when
+  // any of its nodes is released, so that their ids can't be mistaken for
+  // those of other nodes.  operands are compared as edges, complement bit
+  // included
+  struct computed_entry
+  {
+    computed_entry() : version(0), op(-1), f(0), g(0), h(0), result(0) {}
+
+    volatile unsigned int version; // odd while the entry is being written
+    int op;
+    size_t f;
+    size_t g;
+    size_t h;
+    size_t result;
+  };
+
+  typedef std::vector<computed_entry> computed_table_t;
+
   computed_table_t computed_table;
+  unsigned int computed_count; // number of occupied slots
+
+  // <neg_cf edge, pos_cf edge> as raw bits
+  typedef std::pair<size_t, size_t> child_key;
+
+  // slot -> node, a null slot is empty.  the key of an entry is
+  // <neg_cf edge, pos_cf edge> of the node it holds
+  struct subtable
+  {
+    subtable() : slots(initial_subtable_size, (bdd_node*)0), count(0), crowded(0) {}
+
+    std::vector<bdd_node*> slots;
+    unsigned int count; // number of nodes, including those in overflow
+
+    // nodes that didn't fit in slots in parallel mode
+    std::map<child_key, bdd_node*> overflow;
+    volatile int crowded; // in crowded_vars
+  };
+
+  // var -> subtable
+  typedef std::vector<subtable> unique_table_t;
 
-  // <var, node from BDD1, node from Bdd2> -> <node in resulting BDD> 
-  typedef std::map<unique_table_key, bdd_ptr> unique_table_t;
-    
   unique_table_t unique_table;
+  unsigned int unique_count; // number of nodes in all subtables
+
+  // var names, name -> var, and the order
+  std::vector<std::string> var_names;
+  std::map<std::string, int> var_ids;
+  std::vector<int> var_to_level;
+  std::vector<int> level_to_var;
+
+  // var -> whether or not it is a ZDD var, 2 var + positive -> the ZDD var
+  // of that literal, and the other way around.  -1 for none
+  std::vector<bool> zdd_vars;
+  std::vector<int> literal_vars;
+  std::vector<int> literal_sources;
+
+  static unsigned int computed_hash(int op, size_t f, size_t g, size_t h);
+  static unsigned int unique_hash(const bdd_ptr& neg, const bdd_ptr& pos);
+
+  void grow_computed_table();
+  void grow_subtable(subtable& table);
+
+  // get_node for parallel mode
+  bdd_ptr find_or_add_concurrent(int var, const bdd_ptr& left, const bdd_ptr& right);
+  void mark_crowded(int var);
+
+  // a node that isn't in the table yet
+  static bdd_node* new_node(int var, const bdd_ptr& left, const bdd_ptr& right);
+
+  // puts node in the subtable of its var, which must have room for it
+  void insert_in_subtable(bdd_node* node);
+
+  // takes node out of the subtable of its var
+  void erase_from_subtable(bdd_node* node);
+
+  // erases and releases the dead node, and then any of its descendants
+  // that are left dead
+  void erase_dead(bdd_node* node);
+
+  // whether the computed table entry involves a dead node
+  static bool has_dead_node(const computed_entry& entry);
+
+  // reordering helpers (bdd_reorder.cpp)
+  void auto_reorder();
+  void sift(int var, std::clock_t deadline);
+  int move_to_level(int var, int lvl);
+
+  bool reordering;
+  bool reorder_verbose;
+  unsigned int reorder_threshold;
+  unsigned int next_reorder; // unique table size that triggers reordering
+  int truth_table_levels;
+  double max_growth;
+  double reorder_time_limit;
+  unsigned int swap_count;
+  reorder_stats last_reorder_stats;
+
+  double gc_fraction;
+
+  table_stats counters;
+  std::clock_t stats_start; // when the counters were reset
+
+  int op_depth; // number of bdd_op_scopes currently entered
+
+  bool concurrent; // between begin_parallel and end_parallel
+
+  // the vars whose subtables end_parallel has to look at
+  std::vector<int> crowded_vars;
+
+  // in parallel mode, the locks of the overflow maps (a var uses lock
+  // var % num_overflow_locks) and of crowded_vars
+  static const int num_overflow_locks = 64;
+  pthread_mutex_t overflow_locks[num_overflow_locks];
+  pthread_mutex_t crowded_lock;
+};
+
+// bdd_op_scope marks an operation on BDDs in progress, for as long as it
+// exists.  Every function that builds nodes creates one on entry:
+//
+//   bdd_ptr my_operation(bdd_ptr f)
+//   {
+//     bdd_op_scope scope;
+//     ...
+//   }
+//
+// so that the BDDs aren't reordered while the function runs.
+class bdd_op_scope
+{
+public:
+  bdd_op_scope() : tables(bdd_tables::getInstance()) { tables.enter_op(); }
+  ~bdd_op_scope() { tables.leave_op(); }
+
+private:
+  bdd_tables& tables;
 };
 
 #endif
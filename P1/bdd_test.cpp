@@ -0,0 +1,441 @@
+/*
+ * File bdd_test.cpp
+ *
+ * Checks of the BDD package that the sample session (test.in) doesn't
+ * reach.  Each test prints the checks that fail; the exit status is the
+ * number of them.
+ *
+ * usage: bdd_test
+ */
+
+#include "bdd_node.h"
+#include "bdd_tables.h"
+#include "bdd_manager.h"
+#include "project1.h"
+#include "bdd_batch.h"
+#include "bdd_zdd.h"
+#include "bdd_io.h"
+
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+
+using namespace std;
+
+static int failures = 0;
+
+// reports what failed if ok is false
+static void check(bool ok, const string& test, const string& what)
+{
+  if (ok) return;
+  cout << test << ": " << what << endl;
+  ++failures;
+}
+
+// builds in two managers through their wrappers, and copies and drops the
+// results after the wrappers' scopes have ended, while the default manager
+// is current.  the counts of each manager must only change with its own
+// nodes
+static void test_managers()
+{
+  const string test = "managers";
+  bdd_manager& current = bdd_manager::current();
+  unsigned int dead_before = current.dead_count();
+
+  bdd_manager a, b;
+  {
+    bdd_ptr f = a.apply(a.var("x"), a.var("y"), OP_AND);
+    bdd_ptr g = b.apply(b.var("x"), b.var("y"), OP_OR);
+
+    vector<bdd_ptr> copies(10, f);
+    copies.insert(copies.end(), 10, g);
+    copies.push_back(f.complement());
+    copies.clear();
+  }
+  check(current.dead_count() == dead_before, test, "dead count of the current manager changed");
+
+  a.clear();
+  b.clear();
+  check(a.live_count() == 1 && a.dead_count() == 0, test, "nodes left in the first manager");
+  check(b.live_count() == 1 && b.dead_count() == 0, test, "nodes left in the second manager");
+}
+
+// a script whose operands and vars are misspelled: each of those lines
+// fails, and none of them adds a var
+static void test_unknown_names()
+{
+  const string test = "unknown names";
+  bdd_manager m;
+  bdd_manager_scope scope(m);
+  bdd_tables& tables = bdd_tables::getInstance();
+
+  istringstream script("inputs a b\n"
+                       "let f a & b\n"
+                       "apply g or f c\n"
+                       "let h a | d\n"
+                       "cofactor k f e 1\n"
+                       "exists l f x\n"
+                       "apply g or f b\n");
+  ostringstream report;
+  check(run_batch(script, report) == 4, test, "misspelled lines didn't fail");
+  check(report.str().find("line 3: unknown name c") != string::npos, test,
+        "unknown operand not reported");
+  check(report.str().find(": unknown name d") != string::npos, test,
+        "unknown name in let not reported");
+  check(tables.num_vars() == 2, test, "misspelled names were added as vars");
+}
+
+// quantifying or cofactoring with something that isn't a cube gives a
+// null result, and fails the batch line instead of aborting
+static void test_non_cubes()
+{
+  const string test = "non-cubes";
+  bdd_manager m;
+  bdd_manager_scope scope(m);
+  bdd_ptr a = m.var("a"), b = m.var("b");
+  bdd_ptr a_or_b = apply(a, b, OP_OR);
+  bdd_ptr a_not_b = apply(a, b.complement(), OP_AND);
+
+  check(is_cube(a_not_b) && !is_cube(a_not_b, true), test, "a !b misjudged");
+  check(!is_cube(a_or_b) && !is_cube(bdd_node::zero()) && is_cube(bdd_node::one()), test,
+        "non-cubes taken for cubes");
+  check(!exists(a_or_b, a_or_b) && !forall(a, a_not_b) && !and_exists(a, b, a_or_b), test,
+        "quantified by a non-cube");
+  check(!cofactor(a_or_b, bdd_node::zero()) && !cofactor(a, a_or_b), test,
+        "cofactor by a non-cube");
+  check(cofactor(a_or_b, a_not_b).is_one() && exists(a_or_b, apply(a, b, OP_AND)).is_one(), test,
+        "wrong result for a cube");
+
+  istringstream script("inputs a b\n"
+                       "let f a & b\n"
+                       "let g a | b\n"
+                       "exists r f g\n"
+                       "andex r f f 0\n"
+                       "exists r f a\n");
+  ostringstream report;
+  check(run_batch(script, report) == 2, test, "non-cube lines didn't fail");
+  check(report.str().find("line 4: g isn't a conjunction of vars") != string::npos, test,
+        "non-cube not reported");
+}
+
+// isop adds a ZDD var per literal, which must not change the number of
+// models of a BDD
+static void test_count_after_isop()
+{
+  const string test = "count after isop";
+  bdd_manager m;
+  bdd_manager_scope scope(m);
+
+  istringstream script("inputs a b c\n"
+                       "let f a | b | c\n"
+                       "count f\n"
+                       "isop z f\n"
+                       "count f\n");
+  ostringstream report;
+  check(run_batch(script, report) == 0, test, "script failed");
+
+  const string models = "models: 7,";
+  size_t first = report.str().find(models);
+  check(first != string::npos && report.str().find(models, first + 1) != string::npos, test,
+        "count changed after isop");
+}
+
+// BDDs given to the ZDD statements, and ZDDs to isop, fail their lines
+// instead of aborting or being read as the wrong kind
+static void test_operand_kinds()
+{
+  const string test = "operand kinds";
+  bdd_manager m;
+  bdd_manager_scope scope(m);
+
+  istringstream script("inputs a b\n"
+                       "let g a & b\n"
+                       "isop z g\n"
+                       "function f g\n"
+                       "zunion u g z\n"
+                       "zprod u z a\n"
+                       "cover g\n"
+                       "isop y z\n"
+                       "zunion u z 1\n"
+                       "function f u\n");
+  ostringstream report;
+  check(run_batch(script, report) == 5, test, "lines with the wrong kind didn't fail");
+  check(report.str().find("line 4: g isn't a ZDD") != string::npos, test,
+        "BDD given to function not reported");
+  check(report.str().find("line 6: a is a var, not a ZDD") != string::npos, test,
+        "var given to zprod not reported");
+  check(report.str().find("line 8: z isn't a BDD") != string::npos, test,
+        "ZDD given to isop not reported");
+  check(!zdd_union(m.var("a"), bdd_node::one()) && !cover_function(m.var("a")), test,
+        "ZDD operation on a BDD");
+}
+
+// a file with a ZDD node under a complemented edge, or with BDD and ZDD
+// nodes mixed, is rejected as corrupt before anything is built, and a ZDD
+// saved and loaded again is the same
+static void test_load_checks()
+{
+  const string test = "load checks";
+  bdd_manager m;
+  bdd_manager_scope scope(m);
+
+  // vars a+ and b+ (ZDD); node 1 is b+' 0 + b+ 1, node 2 is a+' node 1 +
+  // a+ (node 1)'
+  const char complemented[] = "P1BDD\x02\x02\x05" "a+" "\x05" "b+"
+                              "\x02\x01\x03\x02" "\x00\x02\x03" "\x01\x04";
+  // vars a (BDD) and b+ (ZDD); node 2, on a, has node 1, on b+, as a child
+  const char mixed[] = "P1BDD\x02\x02\x02" "a" "\x05" "b+"
+                       "\x02\x01\x03\x02" "\x00\x02\x02" "\x01\x04";
+
+  vector<bdd_ptr> roots;
+  string error;
+  check(!read_bdds(complemented, sizeof(complemented) - 1, roots, error) &&
+        error == "corrupt BDD file", test, "complemented ZDD edge accepted");
+  check(!read_bdds(mixed, sizeof(mixed) - 1, roots, error) && error == "corrupt BDD file",
+        test, "BDD and ZDD nodes mixed accepted");
+  check(bdd_manager::current().live_count() == 1, test, "nodes built from a corrupt file");
+
+  bdd_ptr f = apply(m.var("a"), m.var("b").complement(), OP_OR);
+  bdd_ptr cover = isop(f);
+  ostringstream os;
+  write_bdds(os, vector<bdd_ptr>(1, cover));
+  check(read_bdds(os.str().data(), os.str().size(), roots, error) && roots.size() == 1 &&
+        roots[0] == cover, test, "saved ZDD not loaded back");
+}
+
+// has_var against the cofactors, with a reordering from a bad order due
+// when has_var starts (in support_cube)
+static void test_has_var_reorder()
+{
+  const string test = "has_var after reordering";
+  bdd_manager m;
+  bdd_manager_scope scope(m);
+  bdd_tables& tables = bdd_tables::getInstance();
+
+  // a0 b0 + a1 b1 + ..., in the order a0 a1 ... b0 b1 ..., with some of
+  // the vars left out
+  vector<int> vars;
+  for (int i = 0; i < 16; ++i)
+  {
+    ostringstream name;
+    name << (i < 8 ? "a" : "b") << i % 8;
+    vars.push_back(tables.add_var(name.str()));
+  }
+  bdd_ptr f = bdd_node::zero();
+  for (int i = 0; i < 8; ++i)
+  {
+    if (i % 3 == 2) continue;
+    f = apply(f, apply(tables.var_bdd(vars[i]), tables.var_bdd(vars[i + 8]), OP_AND), OP_OR);
+  }
+
+  bool right = true;
+  for (size_t i = 0; i < vars.size(); ++i)
+  {
+    bool depends = positive_cofactor(f, vars[i]) != negative_cofactor(f, vars[i]);
+
+    // back to the bad order, which sifting changes
+    tables.set_var_order(vars);
+    tables.set_reordering(true);
+    tables.set_reorder_threshold(1);
+    right = right && f.has_var(vars[i]) == depends;
+    tables.set_reordering(false);
+  }
+  check(right, test, "wrong answer");
+}
+
+// the results of the truth table path of apply and of ite are found by
+// each other, whichever operand comes first and complemented or not
+static void test_truth_table_cache()
+{
+  const string test = "truth table cache";
+  bdd_manager m;
+  bdd_manager_scope scope(m);
+  bdd_tables& tables = bdd_tables::getInstance();
+
+  bdd_ptr a = m.var("a"), b = m.var("b"), c = m.var("c");
+  bdd_ptr f = apply(a, b.complement(), OP_OR);
+  bdd_ptr g = apply(b, c, OP_AND);
+
+  int codes[] = { OP_AND, OP_OR, OP_XOR };
+  bool found = true;
+  for (int i = 0; i < 3; ++i)
+  {
+    for (int truth_first = 0; truth_first < 2; ++truth_first)
+    {
+      tables.clear_computed_table();
+      tables.set_truth_table_threshold(truth_first ? 10 : 0);
+      bdd_ptr res = apply(f, g.complement(), codes[i]);
+
+      tables.set_truth_table_threshold(truth_first ? 0 : 10);
+      unsigned long hits = tables.computed_hit_count();
+      bdd_ptr again = apply(g.complement(), f, codes[i]);
+      found = found && again == res && tables.computed_hit_count() == hits + 1;
+    }
+  }
+  tables.set_truth_table_threshold(10);
+  check(found, test, "result of the other path not found");
+}
+
+// whether every node of f is the one get_node gives for its var and
+// children, i.e. there is no other node for the same function
+static bool canonical(bdd_tables& tables, const bdd_ptr& f)
+{
+  set<bdd_node*> visited;
+  vector<bdd_node*> stack(1, f.node());
+  while (!stack.empty())
+  {
+    bdd_node* n = stack.back();
+    stack.pop_back();
+    if (!visited.insert(n).second || n->is_terminal()) continue;
+
+    if (tables.get_node(n->var, n->neg_cf, n->pos_cf).node() != n) return false;
+    stack.push_back(n->neg_cf.node());
+    stack.push_back(n->pos_cf.node());
+  }
+  return true;
+}
+
+// vector_compose with a substitution for a var that no BDD has yet: the
+// check for the identity substitution mustn't make that var's node
+static void test_compose_no_nodes()
+{
+  const string test = "vector_compose without new nodes";
+  bdd_manager m;
+  bdd_manager_scope scope(m);
+  bdd_tables& tables = bdd_tables::getInstance();
+
+  bdd_ptr a = m.var("a");
+  bdd_ptr b = m.var("b");
+  bdd_ptr f = apply(a, b, OP_AND);
+  int c = tables.add_var("c");
+
+  vector<bdd_ptr> subst(tables.num_vars());
+  subst[a.var()] = a;
+  subst[c] = apply(a, b, OP_OR);
+  check(vector_compose(f, subst) == f, test, "f changed");
+  check(tables.subtable_size(c) == 0, test, "a node was made for c");
+}
+
+// covers with more levels than the call stack has room for recursive calls
+// on: the ZDD operations and isop keep theirs on explicit stacks, as ite
+// does
+static void test_deep_zdds()
+{
+  const string test = "deep ZDDs";
+  bdd_manager m;
+  bdd_manager_scope scope(m);
+  bdd_tables& tables = bdd_tables::getInstance();
+
+  const int n = 100000;
+  vector<bdd_ptr> vars;
+  for (int i = 0; i < n; ++i)
+  {
+    ostringstream name;
+    name << "x" << i;
+    vars.push_back(m.var(name.str()));
+  }
+
+  // the and and the or of all vars, built bottom up so ite stays shallow
+  bdd_ptr all = bdd_node::one();
+  bdd_ptr any = bdd_node::zero();
+  for (int i = n - 1; i >= 0; --i)
+  {
+    all = apply(vars[i], all, OP_AND);
+    any = apply(vars[i], any, OP_OR);
+  }
+
+  // the literal vars in the order of their vars.  added by isop, they
+  // would be in the reverse order, and every change would go to the bottom
+  for (int i = 0; i < n; ++i)
+  {
+    tables.literal_var(vars[i].var(), false);
+    tables.literal_var(vars[i].var(), true);
+  }
+
+  // a single cube of n literals, and n cubes of one literal
+  bdd_ptr cube = isop(all);
+  bdd_ptr singles = isop(any);
+  check(cube && zdd_count(cube) == 1, test, "isop of the and isn't one cube");
+  check(singles && zdd_count(singles) == n, test, "isop of the or isn't n literals");
+  check(cover_function(cube) == all && cover_function(singles) == any, test,
+        "function of a cover differs from the BDD");
+
+  bdd_ptr both = zdd_union(cube, singles);
+  check(zdd_count(both) == n + 1, test, "union has the wrong number of cubes");
+  check(zdd_intersect(both, cube) == cube, test, "intersect lost the cube");
+  check(zdd_diff(both, cube) == singles, test, "diff kept the cube");
+
+  bdd_ptr last = zdd_singleton(tables.literal_var(vars[n - 1].var(), true));
+  check(zdd_product(cube, last) == cube, test, "product with a literal of the cube changed it");
+  check(zdd_change(zdd_change(cube, last.var()), last.var()) == cube, test,
+        "changing a var twice isn't the identity");
+}
+
+// many separate parallel ites, whose subtables fill up past the probe
+// limit between them: the nodes must stay canonical, and the results the
+// same as those of the sequential ite
+static void test_parallel_canonical()
+{
+  const string test = "parallel canonical";
+  bdd_manager m;
+  bdd_manager_scope scope(m);
+  bdd_tables& tables = bdd_tables::getInstance();
+  tables.set_truth_table_threshold(0);
+
+  static const int codes[] = { OP_AND, OP_OR, OP_XOR };
+  vector<bdd_ptr> vars;
+  for (int i = 0; i < 20; ++i)
+  {
+    ostringstream name;
+    name << "v" << i;
+    vars.push_back(m.var(name.str()));
+  }
+
+  vector<bdd_ptr> results[2];
+  for (int pass = 0; pass < 2; ++pass)
+  {
+    set_num_threads(pass ? 1 : 4);
+    tables.clear_computed_table();
+    srand(478);
+    vector<bdd_ptr> pool(vars);
+    for (int i = 0; i < 3000; ++i)
+    {
+      bdd_ptr f = pool[rand() % pool.size()];
+      bdd_ptr g = pool[rand() % pool.size()];
+      pool.push_back(apply(f, rand() % 2 ? g : g.complement(), codes[rand() % 3]));
+    }
+    results[pass] = pool;
+  }
+  set_num_threads(1);
+
+  bool same = true, canon = true;
+  for (size_t i = 0; i < results[0].size(); ++i)
+  {
+    same = same && results[0][i] == results[1][i];
+    canon = canon && canonical(tables, results[0][i]);
+  }
+  check(canon, test, "a node has a duplicate");
+  check(same, test, "parallel and sequential results differ");
+}
+
+int main()
+{
+  test_managers();
+  test_unknown_names();
+  test_non_cubes();
+  test_count_after_isop();
+  test_operand_kinds();
+  test_load_checks();
+  test_has_var_reorder();
+  test_truth_table_cache();
+  test_compose_no_nodes();
+  test_deep_zdds();
+  test_parallel_canonical();
+
+  if (failures) cout << failures << " checks failed" << endl;
+  else cout << "all checks passed" << endl;
+  return failures;
+}
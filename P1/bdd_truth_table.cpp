@@ -0,0 +1,176 @@
+/*
+ * File bdd_truth_table.cpp
+ *
+ * Contains the implementation of the truth table fast path, declared in
+ * bdd_truth_table.h
+ */
+
+#include "bdd_truth_table.h"
+#include "bdd_tables.h"
+#include "operation.h"
+#include "project1.h"
+
+#include <algorithm>
+#include <vector>
+#include <stdint.h>
+
+using namespace std;
+
+typedef uint64_t word_t;
+
+static const int word_vars = 6; // a word holds the table of 6 vars
+static const word_t all_ones = ~(word_t)0;
+
+// var_mask[b] has the bits whose index has bit b set: 0xaaaa... for b = 0,
+// 0xcccc... for b = 1 and so on
+static const word_t var_mask[word_vars] = {
+  all_ones / 3 * 2,
+  all_ones / 5 * 4,
+  all_ones / 17 * 16,
+  all_ones / 257 * 256,
+  all_ones / 65537 * 65536,
+  all_ones << 32
+};
+
+// the truth tables of the BDDs below the k levels from top on.  entry i of
+// a table is the value of the function when the var at level top + j is
+// bit k - 1 - j of i, so the top var splits the table into halves, and the
+// last 6 levels are the bits within a word.  with fewer than 6 levels, a
+// table is a single word whose unused bits repeat the used ones
+class truth_tables
+{
+public:
+  truth_tables(bdd_tables& tables_in, int top_in, int k_in) :
+    tables(tables_in), top(top_in), k(k_in)
+  {
+  }
+
+  // the number of words of a table
+  size_t size() const { return (k > word_vars) ? (size_t)1 << (k - word_vars) : 1; }
+
+  // the table of f, or false if f goes below the k levels
+  bool expand(const bdd_ptr& f, word_t* table) { return fill(f, 0, table, size()); }
+
+  bdd_ptr build(const word_t* table) { return build(table, 0, size()); }
+
+private:
+  // f's var, as its offset in the k levels
+  int position(const bdd_ptr& f) const { return tables.level(f.var()) - top; }
+
+  // the table of f, which only depends on levels j and below, in the n
+  // words at out
+  bool fill(const bdd_ptr& f, int j, word_t* out, size_t n)
+  {
+    if (n == 1)
+    {
+      return word(f, *out);
+    }
+    else if (f.is_terminal())
+    {
+      std::fill(out, out + n, f.is_one() ? all_ones : 0);
+    }
+    else if (position(f) > j)
+    {
+      // f doesn't depend on level j
+      if (!fill(f, j + 1, out, n / 2)) return false;
+      copy(out, out + n / 2, out + n / 2);
+    }
+    else
+    {
+      return fill(f.neg_cf(), j + 1, out, n / 2) &&
+             fill(f.pos_cf(), j + 1, out + n / 2, n / 2);
+    }
+    return true;
+  }
+
+  // the table of f, which only depends on the levels within a word
+  bool word(const bdd_ptr& f, word_t& w)
+  {
+    if (f.is_terminal())
+    {
+      w = f.is_one() ? all_ones : 0;
+      return true;
+    }
+
+    int j = position(f);
+    if (j >= k) return false;
+
+    word_t pos, neg;
+    if (!word(f.pos_cf(), pos) || !word(f.neg_cf(), neg)) return false;
+
+    word_t mask = var_mask[k - 1 - j];
+    w = (mask & pos) | (~mask & neg);
+    return true;
+  }
+
+  // the BDD of the n words at table, which only depend on levels j and
+  // below
+  bdd_ptr build(const word_t* table, int j, size_t n)
+  {
+    if (n == 1) return build_word(*table, min(k, word_vars) - 1);
+
+    const word_t* half = table + n / 2;
+    if (equal(table, half, half)) return build(table, j + 1, n / 2);
+
+    bdd_ptr neg = build(table, j + 1, n / 2);
+    return tables.get_node(tables.var_at_level(top + j), neg, build(half, j + 1, n / 2));
+  }
+
+  // the BDD of the word w, which only depends on the levels of bits b and
+  // below
+  bdd_ptr build_word(word_t w, int b)
+  {
+    if (w == 0) return bdd_node::zero();
+    if (w == all_ones) return bdd_node::one();
+
+    // the cofactors, spread over both halves of each block of bit b
+    int shift = 1 << b;
+    word_t neg = w & ~var_mask[b];
+    neg |= neg << shift;
+    word_t pos = w & var_mask[b];
+    pos |= pos >> shift;
+    if (neg == pos) return build_word(neg, b - 1);
+
+    bdd_ptr neg_bdd = build_word(neg, b - 1);
+    return tables.get_node(tables.var_at_level(top + k - 1 - b), neg_bdd, build_word(pos, b - 1));
+  }
+
+  bdd_tables& tables;
+  int top;
+  int k;
+};
+
+bdd_ptr truth_table_apply(bdd_ptr f, bdd_ptr g, int code, int threshold)
+{
+  if (f.is_terminal() || g.is_terminal()) return bdd_ptr();
+  if (code != OP_AND && code != OP_OR && code != OP_XOR) return bdd_ptr();
+
+  bdd_op_scope scope;
+  bdd_tables& tables = bdd_tables::getInstance();
+
+  // the levels from the top var of f and g down, as many as the threshold
+  // allows.  finding the support first would cost a walk over both
+  int top = min(tables.top_level(f), tables.top_level(g));
+  int k = min(threshold, tables.num_vars() - top);
+
+  truth_tables tt(tables, top, k);
+  size_t n = tt.size();
+  vector<word_t> a(n), b(n);
+  if (!tt.expand(f, &a[0]) || !tt.expand(g, &b[0])) return bdd_ptr();
+
+  // plain loops over the words, which the compiler vectorizes
+  switch (code)
+  {
+    case OP_AND:
+      for (size_t i = 0; i < n; ++i) a[i] &= b[i];
+      break;
+    case OP_OR:
+      for (size_t i = 0; i < n; ++i) a[i] |= b[i];
+      break;
+    default:
+      for (size_t i = 0; i < n; ++i) a[i] ^= b[i];
+      break;
+  }
+
+  return tt.build(&a[0]);
+}
@@ -0,0 +1,43 @@
+#ifndef BDD_TRUTH_TABLE_H
+#define BDD_TRUTH_TABLE_H
+
+/*
+ * File bdd_truth_table.h
+ *
+ * The truth table fast path of apply, for operands that depend on few
+ * vars
+ */
+
+#include "bdd_node.h"
+
+// When f and g only depend on the vars of the threshold number of levels
+// from the top var of either on, apply(f, g, op) doesn't go through ite.
+// f and g are expanded into truth tables over those levels instead, packed
+// 64 entries to a word, the words are combined with the and, or or xor of
+// the machine, and the result is turned back into a BDD.  The tables are
+// at most 2^threshold bits, and the expansion and the rebuilding cost about
+// as many steps as the tables have words, where ite costs a computed table
+// lookup per pair of nodes it visits.  An operand that goes below the
+// levels is found while it is expanded, and apply falls back to ite.
+//
+// The BDD is rebuilt bottom up with get_node, so it is the same canonical
+// BDD that ite would make.  Its top half and bottom half are compared
+// first at every level, and a var whose halves are equal gets no node.
+//
+// apply looks the operation up in the computed table first, as ite does:
+// under CT_ITE, keyed by the standard triple of the ite it stands for.  A
+// result of the truth tables is kept there under the same key, so ite and
+// the truth tables find each other's results.
+//
+// The number of levels of the truth tables is a setting of the tables of
+// each manager (bdd_tables::set_truth_table_threshold).  The default is
+// 10, and it is at most 12: past that, the tables cost more than ite on
+// the benchmark of bdd_bench
+static const int max_truth_table_vars = 12;
+
+// f op g (code is OP_AND, OP_OR or OP_XOR) on truth tables, if f and g
+// only depend on the threshold number of levels from their top var on and
+// neither is a terminal.  otherwise, returns a null bdd_ptr
+bdd_ptr truth_table_apply(bdd_ptr f, bdd_ptr g, int code, int threshold);
+
+#endif
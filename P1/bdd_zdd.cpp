@@ -0,0 +1,662 @@
+/*
+ * File bdd_zdd.cpp
+ *
+ * Contains the implementation of the ZDD operations, declared in
+ * bdd_zdd.h
+ */
+
+#include "bdd_zdd.h"
+#include "bdd_tables.h"
+#include "project1.h"
+
+#include <cassert>
+#include <map>
+#include <vector>
+
+using namespace std;
+
+bool is_zdd(bdd_ptr p)
+{
+  return p.is_terminal() ||
+         (!p.is_complemented() && bdd_tables::getInstance().is_zdd_var(p.var()));
+}
+
+bool is_bdd(bdd_ptr p)
+{
+  return p.is_terminal() || !bdd_tables::getInstance().is_zdd_var(p.var());
+}
+
+bdd_ptr zdd_empty()
+{
+  return bdd_node::zero();
+}
+
+bdd_ptr zdd_base()
+{
+  return bdd_node::one();
+}
+
+bdd_ptr zdd_singleton(int var)
+{
+  bdd_tables& tables = bdd_tables::getInstance();
+  assert(tables.is_zdd_var(var));
+  return tables.get_zdd_node(var, zdd_empty(), zdd_base());
+}
+
+// the operands of a commutative operation in a fixed order, so both orders
+// share computed table entries
+static void order_operands(bdd_ptr& p, bdd_ptr& q)
+{
+  if (q.node() < p.node() || (q.node() == p.node() && p.is_complemented()))
+  {
+    swap(p, q);
+  }
+}
+
+// the families of the sets of p without (positive = false) and with the
+// var at level lvl, with that var taken out.  p's top var must not be
+// above lvl
+static bdd_ptr subset_at(const bdd_tables& tables, const bdd_ptr& p, int lvl, bool positive)
+{
+  if (tables.top_level(p) != lvl) return positive ? zdd_empty() : p;
+  return positive ? p.pos_cf() : p.neg_cf();
+}
+
+// the part of a union, intersect, diff or change call (op is CT_ZDD_UNION,
+// CT_ZDD_INTERSECT, CT_ZDD_DIFF or CT_ZDD_CHANGE) that comes before
+// splitting: the terminal cases and the computed table lookup.  for
+// change, q is the singleton of the var to change.  returns true if the
+// result is known, in res.  otherwise p and q are left as the key of the
+// call
+static bool family_lookup(bdd_tables& tables, int op, bdd_ptr& p, bdd_ptr& q, bdd_ptr& res)
+{
+  switch (op)
+  {
+    case CT_ZDD_UNION:
+      if (p.is_zero() || p == q) { res = q; return true; }
+      if (q.is_zero()) { res = p; return true; }
+      order_operands(p, q);
+      break;
+    case CT_ZDD_INTERSECT:
+      if (p.is_zero() || q.is_zero()) { res = zdd_empty(); return true; }
+      if (p == q) { res = p; return true; }
+      order_operands(p, q);
+      break;
+    case CT_ZDD_DIFF:
+      if (p.is_zero() || p == q) { res = zdd_empty(); return true; }
+      if (q.is_zero()) { res = p; return true; }
+      break;
+    default:
+    {
+      int var = q.var();
+      int lvl = tables.level(var);
+      int top = tables.top_level(p);
+      if (top > lvl) { res = tables.get_zdd_node(var, zdd_empty(), p); return true; }
+      if (top == lvl) { res = tables.get_zdd_node(var, p.pos_cf(), p.neg_cf()); return true; }
+      break;
+    }
+  }
+
+  res = tables.find_in_computed_table(op, p, q);
+  if (res) return true;
+  return false;
+}
+
+// a union, intersect, diff or change call waiting for the results for its
+// children.  next is the child to start next: 0 for the negative one, 1
+// for the positive one, 2 once both are done.  a call with a single child
+// (var is -1) takes the result for it as its own
+struct family_frame
+{
+  family_frame(bdd_tables& tables, int op, const bdd_ptr& p_in, const bdd_ptr& q_in) :
+    p(p_in), q(q_in), var(-1), next(0)
+  {
+    int p_level = tables.top_level(p);
+    int q_level = tables.top_level(q);
+    switch (op)
+    {
+      case CT_ZDD_UNION:
+      {
+        int top = min(p_level, q_level);
+        var = tables.var_at_level(top);
+        for (int i = 0; i < 2; ++i)
+        {
+          child_p[i] = subset_at(tables, p, top, i == 1);
+          child_q[i] = subset_at(tables, q, top, i == 1);
+        }
+        break;
+      }
+      case CT_ZDD_INTERSECT:
+        // the sets with a var that only one of them has at the top are in
+        // that one only
+        if (p_level < q_level)
+        {
+          child_p[0] = p.neg_cf();
+          child_q[0] = q;
+        }
+        else if (q_level < p_level)
+        {
+          child_p[0] = p;
+          child_q[0] = q.neg_cf();
+        }
+        else
+        {
+          var = p.var();
+          child_p[0] = p.neg_cf();
+          child_q[0] = q.neg_cf();
+          child_p[1] = p.pos_cf();
+          child_q[1] = q.pos_cf();
+        }
+        break;
+      case CT_ZDD_DIFF:
+        if (q_level < p_level)
+        {
+          // no set of p has q's top var
+          child_p[0] = p;
+          child_q[0] = q.neg_cf();
+        }
+        else
+        {
+          var = p.var();
+          for (int i = 0; i < 2; ++i)
+          {
+            child_p[i] = (i == 1) ? p.pos_cf() : p.neg_cf();
+            child_q[i] = subset_at(tables, q, p_level, i == 1);
+          }
+        }
+        break;
+      default:
+        var = p.var();
+        child_p[0] = p.neg_cf();
+        child_p[1] = p.pos_cf();
+        child_q[0] = child_q[1] = q;
+        break;
+    }
+  }
+
+  bdd_ptr p, q;          // the key of the call
+  int var;               // the var of the node made for the children
+  bdd_ptr child_p[2], child_q[2];
+  int next;
+  bdd_ptr neg;           // the result for the negative child, once known
+};
+
+// like ite, the pending calls are kept on an explicit stack.  res always
+// holds the result of the call that finished last, which the frame on top
+// of the stack picks up
+static bdd_ptr family_iter(bdd_tables& tables, int op, bdd_ptr p, bdd_ptr q)
+{
+  bdd_ptr res;
+  if (family_lookup(tables, op, p, q, res)) return res;
+
+  vector<family_frame> stack(1, family_frame(tables, op, p, q));
+  while (!stack.empty())
+  {
+    family_frame& frame = stack.back();
+
+    if (frame.next == 1)
+    {
+      frame.neg = res;
+    }
+    if (frame.next == 2 || (frame.next == 1 && frame.var < 0))
+    {
+      if (frame.var >= 0) res = tables.get_zdd_node(frame.var, frame.neg, res);
+      tables.insert_computed_table(op, frame.p, frame.q, bdd_ptr(), res);
+      stack.pop_back();
+      continue;
+    }
+
+    bdd_ptr child_p = frame.child_p[frame.next];
+    bdd_ptr child_q = frame.child_q[frame.next];
+    ++frame.next;
+
+    // frame is invalid once the stack grows
+    if (!family_lookup(tables, op, child_p, child_q, res))
+    {
+      stack.push_back(family_frame(tables, op, child_p, child_q));
+    }
+  }
+
+  return res;
+}
+
+// the family of the sets of p with var added to those without it and
+// taken out of those with it
+static bdd_ptr change_iter(bdd_tables& tables, const bdd_ptr& p, int var)
+{
+  return family_iter(tables, CT_ZDD_CHANGE, p, zdd_singleton(var));
+}
+
+// the terminal cases and the computed table lookup of product, as in
+// family_lookup
+static bool product_lookup(bdd_tables& tables, bdd_ptr& p, bdd_ptr& q, bdd_ptr& res)
+{
+  if (p.is_zero() || q.is_zero()) { res = zdd_empty(); return true; }
+  if (p.is_one()) { res = q; return true; }
+  if (q.is_one()) { res = p; return true; }
+
+  order_operands(p, q);
+  res = tables.find_in_computed_table(CT_ZDD_PRODUCT, p, q);
+  if (res) return true;
+  return false;
+}
+
+// a product call waiting for the products it is made of.  v is the top
+// var of a, which is p or q, then (A0 + v A1) B = A0 B + v A1 B if B
+// doesn't have v, and (A0 + v A1)(B0 + v B1) = A0 B0 + v (A1 B0 + A1 B1 +
+// A0 B1) otherwise.  next is the product to start next, in that order
+struct product_frame
+{
+  product_frame(bdd_tables& tables, const bdd_ptr& p_in, const bdd_ptr& q_in) :
+    p(p_in), q(q_in), next(0)
+  {
+    a = p;
+    bdd_ptr b = q;
+    if (tables.top_level(b) < tables.top_level(a)) swap(a, b);
+    int top = tables.top_level(a);
+    b0 = subset_at(tables, b, top, false);
+    b1 = subset_at(tables, b, top, true);
+    last = b1.is_zero() ? 2 : 4;
+  }
+
+  bdd_ptr p, q;   // the key of the call
+  bdd_ptr a;      // the operand split on
+  bdd_ptr b0, b1; // the other one without and with a's top var
+  int last;       // the number of products
+  int next;
+  bdd_ptr neg;    // A0 B0, once known
+  bdd_ptr pos;    // the union of the products with v so far
+};
+
+// res always holds the result of the call that finished last, which the
+// frame on top of the stack picks up
+static bdd_ptr product_iter(bdd_tables& tables, bdd_ptr p, bdd_ptr q)
+{
+  bdd_ptr res;
+  if (product_lookup(tables, p, q, res)) return res;
+
+  vector<product_frame> stack(1, product_frame(tables, p, q));
+  while (!stack.empty())
+  {
+    product_frame& frame = stack.back();
+
+    if (frame.next == 1)
+    {
+      frame.neg = res;
+    }
+    else if (frame.next == 2)
+    {
+      frame.pos = res;
+    }
+    else if (frame.next > 2)
+    {
+      frame.pos = family_iter(tables, CT_ZDD_UNION, frame.pos, res);
+    }
+
+    if (frame.next == frame.last)
+    {
+      res = tables.get_zdd_node(frame.a.var(), frame.neg, frame.pos);
+      tables.insert_computed_table(CT_ZDD_PRODUCT, frame.p, frame.q, bdd_ptr(), res);
+      stack.pop_back();
+      continue;
+    }
+
+    bdd_ptr child_p = (frame.next == 1 || frame.next == 2) ? frame.a.pos_cf() : frame.a.neg_cf();
+    bdd_ptr child_q = (frame.next < 2) ? frame.b0 : frame.b1;
+    ++frame.next;
+
+    // frame is invalid once the stack grows
+    if (!product_lookup(tables, child_p, child_q, res))
+    {
+      stack.push_back(product_frame(tables, child_p, child_q));
+    }
+  }
+
+  return res;
+}
+
+bdd_ptr zdd_union(bdd_ptr p, bdd_ptr q)
+{
+  if (!is_zdd(p) || !is_zdd(q)) return bdd_ptr();
+  bdd_op_scope scope;
+  return family_iter(bdd_tables::getInstance(), CT_ZDD_UNION, p, q);
+}
+
+bdd_ptr zdd_intersect(bdd_ptr p, bdd_ptr q)
+{
+  if (!is_zdd(p) || !is_zdd(q)) return bdd_ptr();
+  bdd_op_scope scope;
+  return family_iter(bdd_tables::getInstance(), CT_ZDD_INTERSECT, p, q);
+}
+
+bdd_ptr zdd_diff(bdd_ptr p, bdd_ptr q)
+{
+  if (!is_zdd(p) || !is_zdd(q)) return bdd_ptr();
+  bdd_op_scope scope;
+  return family_iter(bdd_tables::getInstance(), CT_ZDD_DIFF, p, q);
+}
+
+bdd_ptr zdd_product(bdd_ptr p, bdd_ptr q)
+{
+  if (!is_zdd(p) || !is_zdd(q)) return bdd_ptr();
+  bdd_op_scope scope;
+  return product_iter(bdd_tables::getInstance(), p, q);
+}
+
+bdd_ptr zdd_change(bdd_ptr p, int var)
+{
+  bdd_op_scope scope;
+  return change_iter(bdd_tables::getInstance(), p, var);
+}
+
+long double zdd_count(bdd_ptr p)
+{
+  // node -> the number of its sets, children first
+  map<bdd_node*, long double> counts;
+  vector<bdd_node*> stack(1, p.node());
+  while (!stack.empty())
+  {
+    bdd_node* n = stack.back();
+    if (n->is_terminal() || counts.count(n))
+    {
+      stack.pop_back();
+      continue;
+    }
+
+    bdd_node* children[2] = { n->neg_cf.node(), n->pos_cf.node() };
+    bool ready = true;
+    for (int i = 0; i < 2; ++i)
+    {
+      if (!children[i]->is_terminal() && !counts.count(children[i]))
+      {
+        stack.push_back(children[i]);
+        ready = false;
+      }
+    }
+    if (!ready) continue;
+
+    stack.pop_back();
+    long double c = 0;
+    bdd_ptr edges[2] = { n->neg_cf, n->pos_cf };
+    for (int i = 0; i < 2; ++i)
+    {
+      if (edges[i].is_terminal()) c += edges[i].is_one() ? 1 : 0;
+      else c += counts[edges[i].node()];
+    }
+    counts[n] = c;
+  }
+
+  if (p.is_terminal()) return p.is_one() ? 1 : 0;
+  return counts[p.node()];
+}
+
+// the cofactor of the BDD f w.r.t. the var at level lvl, which f's top var
+// must not be above
+static bdd_ptr bdd_cofactor(const bdd_tables& tables, const bdd_ptr& f, int lvl, bool positive)
+{
+  if (tables.top_level(f) != lvl) return f;
+  return positive ? f.pos_cf() : f.neg_cf();
+}
+
+// the terminal cases of isop and the computed table lookup.  the covers
+// and their BDDs are both in the computed table; an entry only counts if
+// both are there
+static bool isop_lookup(bdd_tables& tables, const bdd_ptr& lower, const bdd_ptr& upper,
+                        bdd_ptr& cover, bdd_ptr& func)
+{
+  if (lower.is_zero())
+  {
+    cover = zdd_empty();
+    func = bdd_node::zero();
+    return true;
+  }
+  if (upper.is_one())
+  {
+    cover = zdd_base();
+    func = bdd_node::one();
+    return true;
+  }
+
+  cover = tables.find_in_computed_table(CT_ISOP, lower, upper);
+  func = tables.find_in_computed_table(CT_ISOP_BDD, lower, upper);
+  return cover && func;
+}
+
+// an isop call finds the cover of some function between lower and upper,
+// and its BDD func, as
+//
+//   cover = x' cover0 + x cover1 + cover_d
+//
+// where x is the top var.  cover0 (cover1) covers the part of x' lower
+// (x lower) that must have x' (x) in its cubes, because it is outside of
+// x upper (x' upper).  cover_d covers what is left, within both cofactors
+// of upper.  next is the one of the three to start next
+struct isop_frame
+{
+  isop_frame(bdd_tables& tables, const bdd_ptr& lower_in, const bdd_ptr& upper_in) :
+    lower(lower_in), upper(upper_in), next(0)
+  {
+    int top = min(tables.top_level(lower), tables.top_level(upper));
+    x = tables.var_at_level(top);
+    lower0 = bdd_cofactor(tables, lower, top, false);
+    lower1 = bdd_cofactor(tables, lower, top, true);
+    upper0 = bdd_cofactor(tables, upper, top, false);
+    upper1 = bdd_cofactor(tables, upper, top, true);
+  }
+
+  bdd_ptr lower, upper;
+  int x;
+  bdd_ptr lower0, lower1, upper0, upper1;
+  int next;
+  bdd_ptr cover0, func0, cover1, func1; // once known
+};
+
+// like ite, the pending calls are kept on an explicit stack.  cover and
+// func always hold the result of the call that finished last, which the
+// frame on top of the stack picks up
+static void isop_iter(bdd_tables& tables, const bdd_ptr& lower, const bdd_ptr& upper,
+                      bdd_ptr& cover, bdd_ptr& func)
+{
+  if (isop_lookup(tables, lower, upper, cover, func)) return;
+
+  vector<isop_frame> stack(1, isop_frame(tables, lower, upper));
+  while (!stack.empty())
+  {
+    isop_frame& frame = stack.back();
+
+    if (frame.next == 1)
+    {
+      frame.cover0 = cover;
+      frame.func0 = func;
+    }
+    else if (frame.next == 2)
+    {
+      frame.cover1 = cover;
+      frame.func1 = func;
+    }
+    else if (frame.next == 3)
+    {
+      // cover and func are cover_d and func_d
+      int x = frame.x;
+      func = tables.get_node(x, apply(frame.func0, func, OP_OR), apply(frame.func1, func, OP_OR));
+      // x's literal vars are added in this order if they don't exist yet,
+      // which puts x+ above x-
+      bdd_ptr cover1 = change_iter(tables, frame.cover1, tables.literal_var(x, true));
+      bdd_ptr cover0 = change_iter(tables, frame.cover0, tables.literal_var(x, false));
+      cover = family_iter(tables, CT_ZDD_UNION, cover,
+                          family_iter(tables, CT_ZDD_UNION, cover0, cover1));
+
+      tables.insert_computed_table(CT_ISOP, frame.lower, frame.upper, bdd_ptr(), cover);
+      tables.insert_computed_table(CT_ISOP_BDD, frame.lower, frame.upper, bdd_ptr(), func);
+      stack.pop_back();
+      continue;
+    }
+
+    bdd_ptr child_lower, child_upper;
+    if (frame.next == 0)
+    {
+      child_lower = apply(frame.lower0, frame.upper1.complement(), OP_AND);
+      child_upper = frame.upper0;
+    }
+    else if (frame.next == 1)
+    {
+      child_lower = apply(frame.lower1, frame.upper0.complement(), OP_AND);
+      child_upper = frame.upper1;
+    }
+    else
+    {
+      child_lower = apply(apply(frame.lower0, frame.func0.complement(), OP_AND),
+                          apply(frame.lower1, frame.func1.complement(), OP_AND), OP_OR);
+      child_upper = apply(frame.upper0, frame.upper1, OP_AND);
+    }
+    ++frame.next;
+
+    // frame is invalid once the stack grows
+    if (!isop_lookup(tables, child_lower, child_upper, cover, func))
+    {
+      stack.push_back(isop_frame(tables, child_lower, child_upper));
+    }
+  }
+}
+
+bdd_ptr isop(bdd_ptr lower, bdd_ptr upper)
+{
+  if (!is_bdd(lower) || !is_bdd(upper)) return bdd_ptr();
+  bdd_op_scope scope;
+  bdd_ptr cover, func;
+  isop_iter(bdd_tables::getInstance(), lower, upper, cover, func);
+  return cover;
+}
+
+bdd_ptr isop(bdd_ptr f)
+{
+  return isop(f, f);
+}
+
+// the terminal cases and the computed table lookup of cover_function.  a
+// var that is no literal makes the whole result null, which is known then
+static bool cover_lookup(bdd_tables& tables, const bdd_ptr& p, bdd_ptr& res)
+{
+  if (p.is_terminal())
+  {
+    res = p;
+    return true;
+  }
+
+  res = tables.find_in_computed_table(CT_COVER_BDD, p, bdd_ptr());
+  if (res) return true;
+
+  bool positive;
+  return tables.literal_source(p.var(), positive) < 0;
+}
+
+// a cover_function call waiting for the results for its children.  next
+// is the child to start next: 0 for neg_cf, 1 for pos_cf, 2 once both are
+// done
+struct cover_frame
+{
+  cover_frame(bdd_tables& tables, const bdd_ptr& p_in) :
+    p(p_in), next(0)
+  {
+    bool positive;
+    literal = tables.var_bdd(tables.literal_source(p.var(), positive));
+    if (!positive) literal = literal.complement();
+  }
+
+  bdd_ptr p;
+  bdd_ptr literal; // the BDD of p's literal
+  int next;
+  bdd_ptr neg;     // the result for neg_cf, once known
+};
+
+// res always holds the result of the call that finished last, which the
+// frame on top of the stack picks up
+static bdd_ptr cover_function_iter(bdd_tables& tables, const bdd_ptr& p)
+{
+  bdd_ptr res;
+  if (cover_lookup(tables, p, res)) return res;
+
+  vector<cover_frame> stack(1, cover_frame(tables, p));
+  while (!stack.empty())
+  {
+    cover_frame& frame = stack.back();
+
+    if (frame.next == 2)
+    {
+      res = apply(frame.neg, apply(frame.literal, res, OP_AND), OP_OR);
+      tables.insert_computed_table(CT_COVER_BDD, frame.p, bdd_ptr(), bdd_ptr(), res);
+      stack.pop_back();
+      continue;
+    }
+
+    if (frame.next == 1)
+    {
+      frame.neg = res;
+    }
+    bdd_ptr child = (frame.next == 1) ? frame.p.pos_cf() : frame.p.neg_cf();
+    ++frame.next;
+
+    // frame is invalid once the stack grows
+    if (!cover_lookup(tables, child, res))
+    {
+      stack.push_back(cover_frame(tables, child));
+    }
+    else if (!res)
+    {
+      return res;
+    }
+  }
+
+  return res;
+}
+
+bdd_ptr cover_function(bdd_ptr p)
+{
+  if (!is_zdd(p)) return bdd_ptr();
+  bdd_op_scope scope;
+  return cover_function_iter(bdd_tables::getInstance(), p);
+}
+
+void print_cover(ostream& os, bdd_ptr p)
+{
+  if (p.is_zero())
+  {
+    os << "0";
+    return;
+  }
+
+  bdd_tables& tables = bdd_tables::getInstance();
+
+  // depth first over the paths to one.  a path is a node and the literals
+  // above it; the then edge adds the node's literal
+  vector<pair<bdd_ptr, vector<int> > > stack(1, make_pair(p, vector<int>()));
+  bool first = true;
+  while (!stack.empty())
+  {
+    bdd_ptr n = stack.back().first;
+    vector<int> lits;
+    lits.swap(stack.back().second);
+    stack.pop_back();
+
+    if (n.is_zero()) continue;
+    if (n.is_one())
+    {
+      if (!first) os << " | ";
+      first = false;
+      if (lits.empty()) os << "1";
+      for (size_t i = 0; i < lits.size(); ++i)
+      {
+        bool positive;
+        int var = tables.literal_source(lits[i], positive);
+        if (i > 0) os << " & ";
+        if (var < 0) os << tables.var_name(lits[i]);
+        else os << (positive ? "" : "!") << tables.var_name(var);
+      }
+      continue;
+    }
+
+    stack.push_back(make_pair(n.neg_cf(), lits));
+    lits.push_back(n.var());
+    stack.push_back(make_pair(n.pos_cf(), lits));
+  }
+}
@@ -0,0 +1,77 @@
+#ifndef BDD_ZDD_H
+#define BDD_ZDD_H
+
+/*
+ * File bdd_zdd.h
+ *
+ * Zero-suppressed BDDs (S. Minato, "Zero-suppressed BDDs for set
+ * manipulation in combinatorial problems", DAC 1993): families of sets,
+ * and covers
+ */
+
+#include <iostream>
+#include <string>
+#include "bdd_node.h"
+
+// A ZDD represents a family of sets of ZDD vars (see
+// bdd_tables::add_zdd_var).  Its nodes live in the same manager as BDDs,
+// and are edges like them, but they are read differently: the node
+// var' P0 + var P1 is the family of the sets of P0 and those of P1 with
+// var added, and a node whose P1 would be empty is never made (it is P0).
+// So a var that a path skips is absent from its sets, and a ZDD only has
+// nodes for the vars that are in some set.  zero is the empty family and
+// one the family of the empty set; ZDDs have no other complemented edges.
+// A ZDD must only be given to the functions below, and a BDD never; the
+// operations on ZDDs return a null bdd_ptr when given a BDD, and isop when
+// given a ZDD.
+//
+// A cover (a sum of products) is the ZDD of its cubes, as sets of
+// literals: every BDD var x has a ZDD var for x (named x+) and one for x'
+// (named x-), see bdd_tables::literal_var.  Sparse covers of many vars
+// are much smaller as ZDDs than as the BDDs of their cubes.
+//
+// The operations are memoized in the computed table.  Like ite, they keep
+// the pending calls on an explicit stack, so deep ZDDs don't overflow the
+// C stack.
+
+// whether p is a ZDD: a constant, or a regular edge to a node of a ZDD
+// var, and whether it is a BDD: a constant, or a node of a BDD var
+bool is_zdd(bdd_ptr p);
+bool is_bdd(bdd_ptr p);
+
+bdd_ptr zdd_empty();  // {}
+bdd_ptr zdd_base();   // {{}}
+
+// {{var}}, var must be a ZDD var
+bdd_ptr zdd_singleton(int var);
+
+// P + Q, P Q and P - Q as families
+bdd_ptr zdd_union(bdd_ptr p, bdd_ptr q);
+bdd_ptr zdd_intersect(bdd_ptr p, bdd_ptr q);
+bdd_ptr zdd_diff(bdd_ptr p, bdd_ptr q);
+
+// the unate product of P and Q, {p + q : p in P, q in Q}.  for covers
+// this is the and of two sums of products, without removing the cubes
+// that have both a literal and its negation
+bdd_ptr zdd_product(bdd_ptr p, bdd_ptr q);
+
+// P with var toggled in every set
+bdd_ptr zdd_change(bdd_ptr p, int var);
+
+// the number of sets in P
+long double zdd_count(bdd_ptr p);
+
+// an irredundant sum of products of the BDD f, or of some function
+// between the BDDs lower and upper (lower must imply upper), as a cover.
+// found by the algorithm of Minato and Morreale
+bdd_ptr isop(bdd_ptr f);
+bdd_ptr isop(bdd_ptr lower, bdd_ptr upper);
+
+// the BDD of the function of the cover P, or a null bdd_ptr if P has a
+// ZDD var that is no literal
+bdd_ptr cover_function(bdd_ptr p);
+
+// prints the cover P as a sum of products, such as a & !b | c, or 0 or 1
+void print_cover(std::ostream& os, bdd_ptr p);
+
+#endif
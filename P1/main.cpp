@@ -1,10 +1,13 @@
 #include "bdd_node.h"
 #include "operation.h"
 #include "bdd_tables.h"
-#include "Bool_expr_parser.h"
+#include "bdd_compiler.h"
 #include "project1.h"
+#include "bdd_batch.h"
+#include "bdd_netlist.h"
 
 #include <iostream>
+#include <fstream>
 #include <assert.h>
 #include <stdlib.h>
 
@@ -12,35 +15,121 @@ using namespace std;
 
 // prototypes
 char get_command(string prompt, string cmdlist);
-char get_var(bdd_ptr bdd);
+int get_var(bdd_ptr bdd);
 
 bdd_ptr build_bdd_from_input(istream& is);
-bdd_ptr bdd_from_expr(BoolExpr<string> *expr);
+
+// runs the script in the file named path (- for standard input), see
+// bdd_batch.h.  returns the exit status
+static int batch(const char* path)
+{
+  int failed;
+  if (string(path) == "-")
+  {
+    failed = run_batch(cin, cout);
+  }
+  else
+  {
+    ifstream script(path);
+    if (!script)
+    {
+      cerr << "can't open " << path << endl;
+      return 1;
+    }
+    failed = run_batch(script, cout);
+  }
+
+  cout << "tables: ";
+  bdd_tables::getInstance().print_stats(cout);
+
+  // check for memory leak, as in the interactive mode
+  bdd_tables::getInstance().clear();
+  if (bdd_node::live_count() != 1) cout << "-->memory leak!" << endl;
+
+  return failed ? 1 : 0;
+}
+
+// builds the outputs of the BLIF netlist in the file named path, see
+// bdd_netlist.h.  returns the exit status
+static int netlist(const char* path, unsigned int budget)
+{
+  vector<netlist_output> outputs;
+  netlist_stats stats;
+  string error;
+  bool ok = load_netlist(path, budget, outputs, stats, error);
+  if (!outputs.empty() || ok) print_netlist_stats(cout, outputs, stats);
+  if (!ok) cerr << error << endl;
+
+  cout << "tables: ";
+  bdd_tables::getInstance().print_stats(cout);
+
+  outputs.clear();
+  bdd_tables::getInstance().clear();
+  if (bdd_node::live_count() != 1) cout << "-->memory leak!" << endl;
+
+  return ok ? 0 : 1;
+}
 
 // Main function. 
 // It allows the user to input a boolean expression which is then
 // displayed in BDD form, and from there, the user can operate on the BDD 
 // until they quit. A memory leak is checked for at the end of the program.
+//
+// usage: project1                 the interactive mode
+//        project1 -b script       runs a script of operations (- reads it
+//                                 from standard input)
+//        project1 -g kind n       writes the script of a synthetic
+//                                 benchmark (queens, adder, multiplier or
+//                                 parity) of size n
+//        project1 -n file [budget]
+//                                 builds the outputs of a BLIF netlist,
+//                                 with at most budget nodes alive
 int main(int argc, char *argv[])
 {
+  if (argc == 3 && string(argv[1]) == "-b")
+  {
+    return batch(argv[2]);
+  }
+  if (argc == 4 && string(argv[1]) == "-g")
+  {
+    if (!generate_benchmark(argv[2], atoi(argv[3]), cout))
+    {
+      cerr << "unknown benchmark " << argv[2] << endl;
+      return 1;
+    }
+    return 0;
+  }
+  if ((argc == 3 || argc == 4) && string(argv[1]) == "-n")
+  {
+    return netlist(argv[2], (argc == 4) ? strtoul(argv[3], 0, 10) : 0);
+  }
+  if (argc > 1)
+  {
+    cerr << "usage: " << argv[0]
+         << " [-b script | -g queens|adder|multiplier|parity n | -n netlist [budget]]" << endl;
+    return 1;
+  }
+
   cout << "\n-------------------------\n";
   cout << "Project 1: BDDs.\n\n";
   
   cout << "A valid boolean expression consists of\n"
-       << "(1) single character vars, and \n";
+       << "(1) named vars (letters, digits and _), and \n";
   cout << "(2) AND, OR, NOT and parenthesis\n";
   cout << "\n example: (a & !b | !a & b) & c\n";
+  cout << " example: (x1 & !x2 | !x1 & x2) & carry_in\n";
   cout << "-------------------------\n\n";
 
 
-  bdd_node::zero->probability = 0;
-  bdd_node::one->probability = 1;
-
   // print mode from users
   // verbose means the tables will be printed out
   bool verbose = false;
   char pm = get_command(string("Choose a print mode: (v)erbose, (n)on-verbose\n"), string("vn"));
   if (pm == 'v') verbose = true;
+
+  // reorder the BDDs automatically as they grow, and report it
+  bdd_tables::getInstance().set_reordering(true);
+  bdd_tables::getInstance().set_reorder_verbose(true);
   
   // flush input line
   while ( cin.get() != '\n' );
@@ -49,7 +138,7 @@ int main(int argc, char *argv[])
   {
   // get the initial boolean expression
   bdd_ptr expr1 = build_bdd_from_input(cin);
-  if (expr1 == NULL)
+  if (!expr1)
   {
     cout << "function apply not implemented." << endl;
     exit(0);
@@ -58,7 +147,7 @@ int main(int argc, char *argv[])
 			
   
   cout << "in bdd form:\n" << expr1 << endl;
-  cout << endl <<"probability: "<< expr1->probability << endl << endl;
+  cout << endl <<"probability: "<< expr1.probability() << endl << endl;
   
   bool done = false;
   while (!done)
@@ -76,7 +165,7 @@ int main(int argc, char *argv[])
     char choice = get_command(string("\n(a)pply an operation with another bdd?\
 									\n(n)egative cofactor? \n(p)ositive cofactor? \
 									\n(b)oolean difference? \n(s)ort by influence? \
-                                    \n(q)uit\n"),string("anpbsq"));
+                                    \n(r)eorder variables? \n(q)uit\n"),string("anpbsrq"));
     // flush input line
     while (cin.get() != '\n');
     cout << endl;
@@ -89,19 +178,19 @@ int main(int argc, char *argv[])
     {
       case 'n':
       {
-        char var = get_var(expr1);
+        int var = get_var(expr1);
         result = negative_cofactor(expr1, var);
         break;
       }
       case 'p':
       {
-        char var = get_var(expr1);
+        int var = get_var(expr1);
         result = positive_cofactor(expr1, var);
         break;
       }
       case 'b':
       {
-        char var = get_var(expr1);
+        int var = get_var(expr1);
         result = boolean_difference(expr1, var);
         break;
       }
@@ -109,7 +198,7 @@ int main(int argc, char *argv[])
       {
         bdd_ptr expr2 = build_bdd_from_input(cin);    
         cout << "in bdd form:\n" << expr2 << endl;
-  	cout << endl <<"probability: "<< expr2->probability << endl << endl;
+  	cout << endl <<"probability: "<< expr2.probability() << endl << endl;
         
         operation dop;    
         dop.prompt_for_operation();
@@ -121,6 +210,14 @@ int main(int argc, char *argv[])
         result = sort_by_influence(expr1);
         break;
       }
+      case 'r':
+      {
+        bdd_tables::reorder_stats stats = bdd_tables::getInstance().reorder();
+        cout << "sifting: " << stats.nodes_before << " -> " << stats.nodes_after
+             << " nodes" << endl;
+        result = expr1;
+        break;
+      }
       case 'q':
         done = true;
         break;
@@ -132,32 +229,39 @@ int main(int argc, char *argv[])
       expr1 = result;
 	
       cout << "\nresult:\n" << result << endl;
-  	cout << endl <<"probability: "<< expr1->probability << endl << endl;
+  	cout << endl <<"probability: "<< expr1.probability() << endl << endl;
     }
   }
   }
+  // on cerr, so the session's output (test.out) doesn't depend on the
+  // timings
+  cerr << "tables: ";
+  bdd_tables::getInstance().print_stats(cerr);
+
   // clear out tables (and what should be all remaining references to nodes)
   bdd_tables::getInstance().clear();
   
   // check for memory leak
-  if ((bdd_node::id_ctr - bdd_node::free_ids.size()) != 2) cout << "-->memory leak!" << endl;
+  // (only the terminal node should be left)
+  if (bdd_node::live_count() != 1) cout << "-->memory leak!" << endl;
   
   return 0;
 }
 
-// get_var prompts the user for a single character variable until a valid input is
+// get_var prompts the user for a variable name until a valid input is
 // entered. the stream is left intact.
-char get_var(bdd_ptr bdd)
+int get_var(bdd_ptr bdd)
 {  
   bool error = true; 
-  char var;
+  string name;
+  int var = -1;
   while ( error )
   {
     error = false;
-    cout << "Enter a single character variable: ";
+    cout << "Enter a variable: ";
 
     // get string from input, and handle errors if necessary
-    if ( !(cin >> var) )
+    if ( !(cin >> name) )
     {
       error = true; 
       cout << "Bad Command.\n";
@@ -167,8 +271,15 @@ char get_var(bdd_ptr bdd)
 
       // flush input line
       while ( cin.get() != '\n' );
+      continue;
+    }
+    var = bdd_tables::getInstance().find_var(name);
+    if (bdd.is_terminal())
+    {
+      // any var will do, the cofactors of a constant are the constant
+      if (var < 0) var = bdd_tables::getInstance().add_var(name);
     }
-    if (!bdd->has_var(var) && !bdd->is_terminal())
+    else if (var < 0 || !bdd.has_var(var))
     {
       cout << "Variable not part of bdd.\n\n";
       error = true;
@@ -239,103 +350,29 @@ char get_command(string prompt,  // Prompt that is printed to screen asking for
 }
 
 // build_bdd_from_input prompts the user for an expression until a valid
-// one is entered.  the GNU boolstuff package is used to parse the expression.
-// the BoolExpr is then passed to bdd_from_expression, and the result returned
+// one is entered, and returns its BDD.  the expression is compiled by
+// compile_expr, which takes the syntax of the GNU boolstuff package
 bdd_ptr build_bdd_from_input(istream& is)
 {
-  BoolExprParser parser;
   string line;
-  BoolExpr<string> *expr;
-  bool error;
   
-  do
+  while (true)
   {
-    error = false;
     cout << "Enter a boolean expression:\n";
-    if (getline(is, line))
-    {
-      try
-      {
-        expr = parser.parse(line);
-        //cout << "Original expression     : " << flush;
-        //assert(expr != NULL);
-        //expr->print(cout);
-        //cout << expr;
-        //cout << "\n";
-      }
-      catch (BoolExprParser::Error &err)
-      {
-        cerr << "Column " << err.index + 1 << ": error #" << err.code << endl;
-        error = true;
-      }
-    }
-    else
+    if (!getline(is, line))
     {
       cerr << "Bad istream. Exiting.\n";
       exit(1);
     }
-  }while (error);
-  
-  // turn expr into a bdd
-  bdd_ptr ret_val = bdd_from_expr(expr);
-  
-  delete expr;
-  
-  return ret_val;  
-}
-
-// bdd_from_expr takes a boolean expression in the the GNU boolstuff BoolExpr
-// format and turns it into a bdd by recursively navigating the expression and
-// using apply.
-bdd_ptr bdd_from_expr(BoolExpr<string> *expr)
-{
-  // objects needed for apply
-  operation dop;
-  bdd_tables &tables = bdd_tables::getInstance();
 
-  switch (expr->getType())
-  {
-    case BoolExpr<string>::VALUE:
+    try
     {
-      // Boolstuff accepts strings as variables, we'll just use the first char
-      // as the var and disregard the rest
-      char var = expr->getValue()[0];
-      if (var == '0') return bdd_node::zero;
-      
-      if (var == '1') return bdd_node::one;
-      
-      bdd_ptr ret = tables.find_in_unique_table(var, bdd_node::zero, bdd_node::one);
-      if (ret == 0) ret =  tables.create_and_add_to_unique_table(var, bdd_node::zero, bdd_node::one);
-     
-      ret->probability = (bdd_node::zero->probability + bdd_node::one->probability)/2;
-
-      return ret;
-      break;
+      return compile_expr(line);
     }
-    case BoolExpr<string>::NOT:
+    catch (BoolExprParser::Error &err)
     {
-      bdd_ptr ret = bdd_from_expr(expr->getRight());
-      
-      // f XOR 1 = f'
-      return apply(ret, bdd_node::one, "xor");
-      break;
+      cerr << "Column " << err.index + 1 << ": error #" << err.code << endl;
     }
-    case BoolExpr<string>::AND:
-    case BoolExpr<string>::OR:
-    {
-      if ( expr->getType() == BoolExpr<string>::AND ) dop.set_operation("and");
-      else                                            dop.set_operation("or");
-      bdd_ptr lhs = bdd_from_expr(expr->getLeft());
-      bdd_ptr rhs = bdd_from_expr(expr->getRight());
-      bdd_ptr ret_node = apply(lhs, rhs, dop);
-      return ret_node;
-      break;
-    }
-    default:
-      assert(0);
-      break;
   }
-  assert(0);
-  return 0;
 }
 
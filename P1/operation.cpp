@@ -8,12 +8,18 @@ using std::cout;
 using std::cin; 
 using std::endl;
 
+const char* op_name(int code)
+{
+  static const char* names[NUM_OPS] = { "and", "or", "xor" };
+  return (code >= 0 && code < NUM_OPS) ? names[code] : "?";
+}
+
 // default operation = and
 operation::operation()
 {
   init_operation_map();
   command = "and";
-  current_op = &operation::and_func;
+  code = OP_AND;
 }
 
 // specify an existing cmd, if it doesn't exist, use the default AND
@@ -25,22 +31,16 @@ operation::operation(string cmd)
   if (it != operation_map.end())
   {
     command = cmd;
-    current_op = (*it).second;
+    code = (*it).second;
   }
   else
   {
     cerr << "warning, command " << cmd << "isn't predefined.  Using default AND operation\n";
     command = "and";
-    current_op = &operation::and_func;
+    code = OP_AND;
   }
 }
 
-// call the current operation
-bdd_ptr operation::operator() (bdd_ptr left, bdd_ptr right)
-{
-  return (this->*current_op)(left, right);
-}
-
 // set the operation.  if no operation exists for the string provided,
 // returns false, otherwise returns true to indicate success
 bool operation::set_operation(string cmd)
@@ -49,7 +49,7 @@ bool operation::set_operation(string cmd)
   if (it != operation_map.end())
   {
     command = cmd;
-    current_op = (*it).second;
+    code = (*it).second;
     return true;
   }
   return false;
@@ -87,88 +87,13 @@ void operation::prompt_for_operation()
   } while (error);
 }
 
-// initializes the map from operation names to operation functions
+// initializes the map from operation names to op_codes
 // this function must be updated if new opeartions are defined
 void operation::init_operation_map()
 {
-  operation_map["and"] = &operation::and_func;
-  operation_map["or"] = &operation::or_func;
-  operation_map["xor"] = &operation::xor_func;
-}
-
-
-// operations that work for terminal cases
-// a null pointer is returned otherwise
-
-bdd_ptr operation::and_func(bdd_ptr left, bdd_ptr right)
-{
-  // f & f = f
-  if (left == right)
-  {
-    return left;
-  }
-  
-  if (left->is_terminal())
-  {
-    // if the left is one, than the result is right. otherwise
-    // the result is zero (which left must be since it is 
-    // terminal and not one)
-    return (left->is_one()) ? right : left;
-  }
-  if (right->is_terminal())
-  {
-    // similar logic applied here
-    return (right->is_one()) ? left : right;
-  }
-
-  return 0;
-}
-
-bdd_ptr operation::or_func(bdd_ptr left, bdd_ptr right)
-{
-  // f + f = f
-  if (left == right)
-  {
-    return left;
-  }
-  
-  if (left->is_terminal())
-  {
-    // if left is 1, return 1 (left)
-    // otherwise, left is 0, so return right
-    // (since anything OR 0 = anything)
-    return (left->is_one()) ? left : right;
-  }
-  if (right->is_terminal())
-  {
-    // similar logic applied here
-    return (right->is_one()) ? right : left;
-  }
-  return 0;
-}
-
-
-bdd_ptr operation::xor_func(bdd_ptr left, bdd_ptr right)
-{
-  // terminal case: f xor 0 = f
-  if (left->is_zero())
-  {
-    return right;
-  }
-  if (right->is_zero())
-  {
-    return left;
-  }
-
-  // terminal case: 1 xor 1 = 0
-  if (left->is_one() && right->is_one())
+  for (int c = 0; c < NUM_OPS; ++c)
   {
-    return bdd_node::zero;
+    operation_map[op_name(c)] = c;
   }
-
-  return 0;
 }
 
-
-
-
@@ -5,16 +5,28 @@
 
 #include "bdd_node.h"
 
-// operation is a function object (overloads operator () ), that is used
-// by the apply function one two bdd_nodes.  Operation manages boolean operations.
-// An Operation object allows you to specify what operation you want to apply before
-// calling it with two Bdd_nodes.  In general, the operations will return a pointer
-// to a Bdd_node if the operation was terminal, or 0 if not (the operation will only
-// work if at least one of the nodes is terminal)
+// integer codes for the predefined operations.  apply turns each of these
+// into an ite call, so a boolean operation never compares strings
+enum op_code
+{
+  OP_AND,
+  OP_OR,
+  OP_XOR,
+  NUM_OPS
+};
+
+// the name of an op_code, as accepted by operation::set_operation
+const char* op_name(int code);
+
+// operation names one of the boolean operations that apply can perform on
+// two bdd_nodes.  An Operation object allows you to specify what operation
+// you want to apply before calling apply with two Bdd_nodes.  apply only
+// looks at the op_code (get_code()); the names are for user interaction.
 //
-// Currently, AND and OR are supported, but you can define more if you want, by adding
-// a prototype to this definition, providing the function definition in operation.cpp,
-// and updating init_operation_map() appropriately. 
+// Currently, AND, OR and XOR are supported.  All of them are computed as
+// ite(f, g, h) (see project1.h), so defining another operation means adding
+// an op_code, its name in op_name(), an entry in init_operation_map() and
+// the corresponding ite call in apply.
 class operation
 {
 public:
@@ -25,17 +37,14 @@ public:
   // specify an existing cmd
   operation(std::string cmd);
 
-  // type: ptr to member function that operates on bdd nodes
-  typedef bdd_ptr (operation::*operation_t) (bdd_ptr, bdd_ptr);
-
-  // calls the current operation on left, right. returns 0 if non-terminal
-  bdd_ptr operator() (bdd_ptr left, bdd_ptr right);
-
   // User command management
   bool set_operation(std::string cmd);
 
   std::string get_operation() {return command;}
 
+  // the op_code of the current operation
+  int get_code() {return code;}
+
   void print_available_operations();
 
   // prints out the available commands and prompts the user for a valid command
@@ -45,24 +54,14 @@ public:
   std::string current_operation() {return command;}
 private:
   std::string command; // name of current operation
-  operation_t current_op; // current operation
+  int code; // op_code of current operation
 
-   // a mapping from the name of the operation to a pointer to the function
-  // that implements it
-  typedef std::map<std::string, operation_t> operation_map_t;
+  // a mapping from the name of the operation to its op_code
+  typedef std::map<std::string, int> operation_map_t;
   operation_map_t operation_map;  
 
-  // initializes operation_map with the available operation names and pointers
+  // initializes operation_map with the available operation names and codes
   void init_operation_map();
-
-  // predefined commands
-
-  // return 0 if not terminal
-  bdd_ptr and_func(bdd_ptr left, bdd_ptr right);
-
-  bdd_ptr or_func(bdd_ptr left, bdd_ptr right);
-
-  bdd_ptr xor_func(bdd_ptr left, bdd_ptr right);
 };
 
 #endif
@@ -1,5 +1,7 @@
 /*
  * Contains the the apply function, the cofactors and quantification functions.
+ * apply is implemented on top of ite, the if-then-else operator, and the
+ * cofactors on top of cofactor, which restricts a BDD to a cube.
  *
  * For Project 1, implement
  * (1) apply, also handles probabilities
@@ -10,8 +12,14 @@
  */
 
 #include "project1.h"
+#include "bdd_parallel.h"
+#include "bdd_manager.h"
+#include "bdd_truth_table.h"
 #include <algorithm>
 #include <vector>
+#include <map>
+#include <set>
+#include <cmath>
 
 using namespace std;
 
@@ -23,144 +31,1256 @@ bdd_ptr apply(bdd_ptr bdd1, bdd_ptr bdd2, string o)
   { 
     return 0;
   }
-  return apply(bdd1, bdd2, dop);
+  return apply(bdd1, bdd2, dop.get_code());
 }
 
-// apply implements an arbitrary operation (specified in op) on two BDDs
-// bdd_tables is used to handle the book keeping (see bdd_tables.h).
-//
-// apply works recursively one the idea that given an arbitrary operation $, 
-// and functions f and g: f $ g = a'(fa' $ ga') + a(fa $ ga), 
-// where a is a variable, fa' is the negative cofactor etc.
 bdd_ptr apply(bdd_ptr bdd1, bdd_ptr bdd2, operation &op)
 {
-  // get reference to tables
+  return apply(bdd1, bdd2, op.get_code());
+}
+
+// apply implements an arbitrary operation (specified by its op_code) on
+// two BDDs by expressing it as an if-then-else:
+//   f & g = ite(f, g, 0),  f + g = ite(f, 1, g),  f ^ g = ite(f, g', g)
+// unless they lie in few enough levels for the truth table fast path
+// (see bdd_truth_table.h)
+//
+// the truth tables are only tried once the computed table, looked up with
+// the same standard triple as ite, doesn't have the result, and their
+// result is kept there under that triple
+static bool ite_lookup(bdd_tables& tables, bdd_ptr& f, bdd_ptr& g, bdd_ptr& h,
+                       bool& comp, bdd_ptr& res);
+
+bdd_ptr apply(bdd_ptr bdd1, bdd_ptr bdd2, int code)
+{
+  bdd_ptr f = bdd1, g, h;
+  switch (code)
+  {
+    case OP_AND:
+      g = bdd2;
+      h = bdd_node::zero();
+      break;
+    case OP_OR:
+      g = bdd_node::one();
+      h = bdd2;
+      break;
+    case OP_XOR:
+      g = bdd2.complement();
+      h = bdd2;
+      break;
+    default:
+      assert(0);
+      return 0;
+  }
+
   bdd_tables& tables = bdd_tables::getInstance();
-  // ... your code goes here
-  bdd_ptr res;
+  int threshold = tables.truth_table_threshold();
+  if (threshold <= 0) return ite(f, g, h);
 
-  res = tables.find_in_computed_table(op.get_operation(), bdd1, bdd2);
-  if (res) return res;
+  bdd_op_scope scope;
+  bool comp;
+  bdd_ptr res;
+  if (ite_lookup(tables, f, g, h, comp, res)) return res;
 
-  // terminal case  
-  res = op(bdd1,bdd2);
-  if (res) {
-    if (res->is_zero()) res->probability = 0;
-    else if(res->is_one()) res->probability = 1;
-    else if(bdd1->is_terminal()) res->probability = bdd2->probability;
-    else res->probability = bdd1->probability;
+  // f, g and h are the standard triple now, whose result is complemented
+  // if comp is set
+  res = truth_table_apply(bdd1, bdd2, code, threshold);
+  if (res)
+  {
+    tables.insert_computed_table(CT_ITE, f, g, h, comp ? res.complement() : res);
     return res;
   }
+  res = ite(f, g, h);
+  return comp ? res.complement() : res;
+}
+
+// true if f should come before g as the first argument of a standard
+// triple: f's top var is at a lower level, or the vars are equal and f's
+// node has the lower id.  terminals come last
+static bool precedes(const bdd_tables& tables, const bdd_ptr& f, const bdd_ptr& g)
+{
+  int f_level = tables.top_level(f);
+  int g_level = tables.top_level(g);
+  if (f_level != g_level) return f_level < g_level;
+  return !f.is_terminal() && f.get_id() < g.get_id();
+}
+
+// ite computes f g + f' h, the operator all of the boolean operations are
+// built on.  bdd_tables is used to handle the book keeping (see bdd_tables.h).
+//
+// ite works on the idea that, for a variable a,
+// ite(f, g, h) = a' ite(fa', ga', ha') + a ite(fa, ga, ha),
+// where fa' is the negative cofactor etc.
+//
+// Before looking in the computed table, the arguments are rewritten into a
+// standard triple, so that the many equivalent ways of writing the same ite
+// share one computed table entry:
+//  - an argument equal to f or f' is replaced by a constant
+//  - with a constant argument, the argument that comes first in the var
+//    order (see precedes) becomes f, e.g. ite(f, 1, h) = ite(h, 1, f)
+//  - f and g are made regular edges, complementing h and/or the result
+//
+// ite keeps the calls it still has to finish on an explicit stack, so the
+// depth of the BDDs is not limited by the size of the call stack.
+// ite_recursive computes the same results the straightforward recursive way;
+// it is kept for comparison (see bdd_bench.cpp).
+//
+// When the thread pool has more than one thread, ite runs in parallel (see
+// ite_par below)
+static bdd_ptr ite_iter(bdd_tables& tables, bdd_ptr f, bdd_ptr g, bdd_ptr h);
+static bdd_ptr ite_rec(bdd_tables& tables, bdd_ptr f, bdd_ptr g, bdd_ptr h);
+static bdd_ptr ite_parallel(bdd_tables& tables, bdd_ptr f, bdd_ptr g, bdd_ptr h);
+
+bdd_ptr ite(bdd_ptr f, bdd_ptr g, bdd_ptr h)
+{
+  bdd_op_scope scope;
+  bdd_tables& tables = bdd_tables::getInstance();
+  if (bdd_thread_pool::getInstance().num_threads() > 1 && !tables.in_parallel())
+  {
+    return ite_parallel(tables, f, g, h);
+  }
+  return ite_iter(tables, f, g, h);
+}
+
+void set_num_threads(int n)
+{
+  bdd_thread_pool::getInstance().set_num_threads(n);
+}
+
+bdd_ptr ite_recursive(bdd_ptr f, bdd_ptr g, bdd_ptr h)
+{
+  bdd_op_scope scope;
+  return ite_rec(bdd_tables::getInstance(), f, g, h);
+}
+
+// the part of an ite call that comes before splitting: the terminal cases,
+// the standard triple and the computed table lookup.  returns true if the
+// result is known, in res.  otherwise f, g and h are left as the standard
+// triple, and the result of ite on it has to be complemented if comp is set
+static bool ite_lookup(bdd_tables& tables, bdd_ptr& f, bdd_ptr& g, bdd_ptr& h,
+                       bool& comp, bdd_ptr& res)
+{
+  // terminal cases
+  if (f.is_one()) { res = g; return true; }
+  if (f.is_zero()) { res = h; return true; }
+  if (g == h) { res = g; return true; }
+  if (g.is_one() && h.is_zero()) { res = f; return true; }
+  if (g.is_zero() && h.is_one()) { res = f.complement(); return true; }
+
+  // replace arguments that are equal to f, or to f', by constants
+  if (g == f) g = bdd_node::one();
+  else if (g == f.complement()) g = bdd_node::zero();
+  if (h == f) h = bdd_node::zero();
+  else if (h == f.complement()) h = bdd_node::one();
+
+  if (g == h) { res = g; return true; }
+  if (g.is_one() && h.is_zero()) { res = f; return true; }
+  if (g.is_zero() && h.is_one()) { res = f.complement(); return true; }
+
+  // pick the first argument among the equivalent triples
+  if (g.is_one())
+  {
+    // ite(f, 1, h) = ite(h, 1, f)
+    if (precedes(tables, h, f)) std::swap(f, h);
+  }
+  else if (h.is_zero())
+  {
+    // ite(f, g, 0) = ite(g, f, 0)
+    if (precedes(tables, g, f)) std::swap(f, g);
+  }
+  else if (h.is_one())
+  {
+    // ite(f, g, 1) = ite(g', f', 1)
+    if (precedes(tables, g, f))
+    {
+      bdd_ptr tmp = f;
+      f = g.complement();
+      g = tmp.complement();
+    }
+  }
+  else if (g.is_zero())
+  {
+    // ite(f, 0, h) = ite(h', 0, f')
+    if (precedes(tables, h, f))
+    {
+      bdd_ptr tmp = f;
+      f = h.complement();
+      h = tmp.complement();
+    }
+  }
+  else if (g == h.complement())
+  {
+    // ite(f, g, g') = ite(g, f, f')
+    if (precedes(tables, g, f))
+    {
+      bdd_ptr tmp = f;
+      f = g;
+      g = tmp;
+      h = tmp.complement();
+    }
+  }
+
+  // make f regular: ite(f', g, h) = ite(f, h, g)
+  if (f.is_complemented())
+  {
+    f = f.complement();
+    std::swap(g, h);
+  }
 
-  // not a terminal case
-  char var = find_next_var(bdd1, bdd2);
+  // make g regular: ite(f, g', h) = ite(f, g, h')'
+  comp = g.is_complemented();
+  if (comp)
+  {
+    g = g.complement();
+    h = h.complement();
+  }
+
+  res = tables.find_in_computed_table(CT_ITE, f, g, h);
+  if (res)
+  {
+    if (comp) res = res.complement();
+    return true;
+  }
+  return false;
+}
+
+// the level of the top var of the three arguments, which is split on
+static int ite_top_level(const bdd_tables& tables, const bdd_ptr& f, const bdd_ptr& g,
+                         const bdd_ptr& h)
+{
+  return std::min(tables.top_level(f), std::min(tables.top_level(g), tables.top_level(h)));
+}
+
+// the cofactor of f w.r.t. the var at level lvl, which is f itself if its
+// top var is below lvl
+static bdd_ptr cofactor_at(const bdd_tables& tables, const bdd_ptr& f, int lvl, bool positive)
+{
+  if (tables.top_level(f) != lvl) return f;
+  return positive ? f.pos_cf() : f.neg_cf();
+}
 
-  if (bdd1->var == var && bdd2->var == var) 
-    res = tables.create_and_add_to_unique_table(var, apply(bdd1->neg_cf, bdd2->neg_cf, op), apply(bdd1->pos_cf, bdd2->pos_cf, op));
-  else if (bdd1->var == var && bdd2->var != var) 
-    res = tables.create_and_add_to_unique_table(var, apply(bdd1->neg_cf, bdd2, op), apply(bdd1->pos_cf, bdd2, op));
-  else   //bdd1->var != var && bdd2->var == var
-    res = tables.create_and_add_to_unique_table(var, apply(bdd1, bdd2->neg_cf, op), apply(bdd1, bdd2->pos_cf, op));
+// the recursive version of ite
+static bdd_ptr ite_rec(bdd_tables& tables, bdd_ptr f, bdd_ptr g, bdd_ptr h)
+{
+  bool comp;
+  bdd_ptr res;
+  if (ite_lookup(tables, f, g, h, comp, res)) return res;
+
+  int top = ite_top_level(tables, f, g, h);
+  bdd_ptr neg = ite_rec(tables, cofactor_at(tables, f, top, false),
+                        cofactor_at(tables, g, top, false), cofactor_at(tables, h, top, false));
+  bdd_ptr pos = ite_rec(tables, cofactor_at(tables, f, top, true),
+                        cofactor_at(tables, g, top, true), cofactor_at(tables, h, top, true));
+
+  // reduces the node if both cofactors are equal, and keeps it canonical
+  // w.r.t. complemented edges
+  res = tables.get_node(tables.var_at_level(top), neg, pos);
+
+  tables.insert_computed_table(CT_ITE, f, g, h, res);
+  return comp ? res.complement() : res;
+}
+
+// an ite call of the iterative version that is waiting for the results of
+// its two halves.  next is the half to start next: 0 for the negative
+// cofactor, 1 for the positive one, 2 once both are done
+struct ite_frame
+{
+  ite_frame(const bdd_ptr& f_in, const bdd_ptr& g_in, const bdd_ptr& h_in, bool comp_in, int top_in) :
+    f(f_in), g(g_in), h(h_in), comp(comp_in), top(top_in), next(0)
+  {}
+
+  bdd_ptr f, g, h; // the standard triple
+  bool comp;       // whether the result is complemented
+  int top;         // the level split on
+  int next;
+  bdd_ptr neg;     // the result for the negative cofactors, once known
+};
+
+// the iterative version of ite.  res always holds the result of the call
+// that finished last, which the frame on top of the stack picks up
+static bdd_ptr ite_iter(bdd_tables& tables, bdd_ptr f, bdd_ptr g, bdd_ptr h)
+{
+  bool comp;
+  bdd_ptr res;
+  if (ite_lookup(tables, f, g, h, comp, res)) return res;
 
-  if (res->neg_cf->get_id() == res->pos_cf->get_id()) return res->neg_cf;
+  vector<ite_frame> stack;
+  stack.push_back(ite_frame(f, g, h, comp, ite_top_level(tables, f, g, h)));
+
+  while (!stack.empty())
+  {
+    ite_frame& frame = stack.back();
+
+    if (frame.next == 2)
+    {
+      res = tables.get_node(tables.var_at_level(frame.top), frame.neg, res);
+      tables.insert_computed_table(CT_ITE, frame.f, frame.g, frame.h, res);
+      if (frame.comp) res = res.complement();
+      stack.pop_back();
+      continue;
+    }
+
+    if (frame.next == 1)
+    {
+      frame.neg = res;
+    }
+    bool positive = (frame.next == 1);
+    ++frame.next;
+
+    bdd_ptr f1 = cofactor_at(tables, frame.f, frame.top, positive);
+    bdd_ptr g1 = cofactor_at(tables, frame.g, frame.top, positive);
+    bdd_ptr h1 = cofactor_at(tables, frame.h, frame.top, positive);
+
+    // frame is invalid once the stack grows
+    if (!ite_lookup(tables, f1, g1, h1, comp, res))
+    {
+      stack.push_back(ite_frame(f1, g1, h1, comp, ite_top_level(tables, f1, g1, h1)));
+    }
+  }
 
-  tables.insert_computed_table(op.get_operation(), bdd1, bdd2, res);
-  res->probability = 0.5*res->neg_cf->probability + 0.5*res->pos_cf->probability;
-  // change the return value when you're finished  
   return res;
 }
 
-// negative_cofactor takes the BDD pointed to by np, 
-// and returns the negative cofactor with respect to var.
-bdd_ptr negative_cofactor(bdd_ptr np, char var)
+// the parallel version of ite.  the calls near the top of the recursion
+// spawn the positive half as a task on the thread pool and compute the
+// negative half themselves, so idle threads can steal the positive halves.
+// below spawn_depth, the halves are computed by ite_iter.  bdd_tables is in
+// parallel mode meanwhile (see bdd_tables.h), which keeps the nodes
+// canonical while several threads create them
+static bdd_ptr ite_par(bdd_tables& tables, bdd_ptr f, bdd_ptr g, bdd_ptr h, int depth);
+
+// the number of levels of the recursion that spawn tasks.  a few more
+// levels than needed to give every thread one task leave room for
+// balancing the load
+static int spawn_depth()
+{
+  int depth = 4;
+  for (int n = 1; n < bdd_thread_pool::getInstance().num_threads(); n *= 2)
+  {
+    depth += 2;
+  }
+  return depth;
+}
+
+// a task is made and synced in the spawning thread's manager, and run by
+// whichever thread gets to it, with that manager made current
+struct ite_task : public bdd_task
+{
+  ite_task(bdd_tables& tables_in, const bdd_ptr& f_in, const bdd_ptr& g_in,
+           const bdd_ptr& h_in, int depth_in) :
+    manager(bdd_manager::current()), tables(tables_in), f(f_in), g(g_in), h(h_in),
+    depth(depth_in)
+  {}
+
+  void run()
+  {
+    bdd_manager_scope scope(manager);
+    result = ite_par(tables, f, g, h, depth);
+  }
+
+  bdd_manager& manager;
+  bdd_tables& tables;
+  bdd_ptr f, g, h;
+  int depth;
+  bdd_ptr result;
+};
+
+static bdd_ptr ite_par(bdd_tables& tables, bdd_ptr f, bdd_ptr g, bdd_ptr h, int depth)
 {
-  // get reference to tables
+  if (depth >= spawn_depth()) return ite_iter(tables, f, g, h);
+
+  bool comp;
+  bdd_ptr res;
+  if (ite_lookup(tables, f, g, h, comp, res)) return res;
+
+  int top = ite_top_level(tables, f, g, h);
+  bdd_thread_pool& pool = bdd_thread_pool::getInstance();
+
+  ite_task pos(tables, cofactor_at(tables, f, top, true), cofactor_at(tables, g, top, true),
+               cofactor_at(tables, h, top, true), depth + 1);
+  pool.spawn(pos);
+  bdd_ptr neg = ite_par(tables, cofactor_at(tables, f, top, false),
+                        cofactor_at(tables, g, top, false), cofactor_at(tables, h, top, false),
+                        depth + 1);
+  pool.sync(pos);
+
+  res = tables.get_node(tables.var_at_level(top), neg, pos.result);
+  tables.insert_computed_table(CT_ITE, f, g, h, res);
+  return comp ? res.complement() : res;
+}
+
+static bdd_ptr ite_parallel(bdd_tables& tables, bdd_ptr f, bdd_ptr g, bdd_ptr h)
+{
+  // many calls are answered right away, and aren't worth waking the pool
+  bool comp;
+  bdd_ptr res;
+  if (ite_lookup(tables, f, g, h, comp, res)) return res;
+
+  ite_task root(tables, f, g, h, 0);
+
+  tables.begin_parallel();
+  bdd_thread_pool::getInstance().run(root);
+  tables.end_parallel();
+
+  return comp ? root.result.complement() : root.result;
+}
+
+// cofactor computes the generalized cofactor of f w.r.t. a cube, a
+// conjunction of literals such as a b' d: the function f with every var of
+// the cube set to make its literal true.  restrict is the cofactor w.r.t. a
+// single literal.
+//
+// the graph of f is walked once, top down.  a cube var above f's top var
+// doesn't matter and is skipped; at a cube var, f is replaced by the child
+// the literal selects; elsewhere, a node is built for the cofactors of f's
+// children.  results are kept in the computed table under CT_COFACTOR, keyed
+// by f and the rest of the cube.  like ite, the pending calls are kept on an
+// explicit stack
+static bdd_ptr cofactor_iter(bdd_tables& tables, bdd_ptr f, bdd_ptr cube);
+
+bool is_cube(bdd_ptr cube, bool vars_only)
+{
+  while (!cube.is_terminal())
+  {
+    if (cube.neg_cf().is_zero()) cube = cube.pos_cf();
+    else if (!vars_only && cube.pos_cf().is_zero()) cube = cube.neg_cf();
+    else return false;
+  }
+  return cube.is_one();
+}
+
+bdd_ptr cofactor(bdd_ptr f, bdd_ptr cube)
+{
+  if (!is_cube(cube)) return bdd_ptr();
+  bdd_op_scope scope;
+  return cofactor_iter(bdd_tables::getInstance(), f, cube);
+}
+
+bdd_ptr restrict(bdd_ptr f, int var, bool value)
+{
+  bdd_op_scope scope;
   bdd_tables& tables = bdd_tables::getInstance();
-  
-  //... your code goes here
-  if (np->is_terminal()) return np;
-  if(np->var==var) return np->neg_cf;
-  if (!(np->has_var(var))) return np;
+  bdd_ptr literal = tables.var_bdd(var);
+  return cofactor_iter(tables, f, value ? literal : literal.complement());
+}
+
+// splits the top literal off a cube.  returns whether it is a positive
+// literal, and sets rest to the remaining literals
+static bool split_cube(const bdd_ptr& cube, bdd_ptr& rest)
+{
+  if (cube.neg_cf().is_zero())
+  {
+    rest = cube.pos_cf();
+    return true;
+  }
+  // otherwise this isn't a cube
+  assert(cube.pos_cf().is_zero());
+  rest = cube.neg_cf();
+  return false;
+}
+
+// the part of a cofactor call that comes before splitting: the terminal
+// cases, the cube vars that can be dealt with right away and the computed
+// table lookup.  returns true if the result is known, in res.  otherwise
+// f and cube are left as the key of the call
+static bool cofactor_lookup(bdd_tables& tables, bdd_ptr& f, bdd_ptr& cube, bdd_ptr& res)
+{
+  for (;;)
+  {
+    if (f.is_terminal() || cube.is_one())
+    {
+      res = f;
+      return true;
+    }
+
+    int f_level = tables.top_level(f);
+    int cube_level = tables.top_level(cube);
+    if (cube_level > f_level) break;
+
+    bdd_ptr rest;
+    bool positive = split_cube(cube, rest);
+    if (cube_level == f_level)
+    {
+      f = positive ? f.pos_cf() : f.neg_cf();
+    }
+    cube = rest;
+  }
 
-  bdd_ptr root = tables.find_in_unique_table(np->var, bdd_node::zero, bdd_node::one);
-  bdd_ptr root_bar = apply(root, bdd_node::one, "xor");
-  bdd_ptr left = apply( root_bar, negative_cofactor(np->neg_cf, var) , "and");
-  bdd_ptr right = apply( root, negative_cofactor(np->pos_cf, var), "and");
-  return apply( left, right, "or");
+  res = tables.find_in_computed_table(CT_COFACTOR, f, cube);
+  if (res) return true;
+  return false;
+}
+
+// a cofactor call waiting for the results for its children.  next is the
+// child to start next: 0 for neg_cf, 1 for pos_cf, 2 once both are done
+struct cofactor_frame
+{
+  cofactor_frame(const bdd_ptr& f_in, const bdd_ptr& cube_in) :
+    f(f_in), cube(cube_in), next(0)
+  {}
+
+  bdd_ptr f, cube;
+  int next;
+  bdd_ptr neg; // the result for neg_cf, once known
+};
+
+// res always holds the result of the call that finished last, which the
+// frame on top of the stack picks up
+static bdd_ptr cofactor_iter(bdd_tables& tables, bdd_ptr f, bdd_ptr cube)
+{
+  bdd_ptr res;
+  if (cofactor_lookup(tables, f, cube, res)) return res;
+
+  vector<cofactor_frame> stack(1, cofactor_frame(f, cube));
+  while (!stack.empty())
+  {
+    cofactor_frame& frame = stack.back();
+
+    if (frame.next == 2)
+    {
+      res = tables.get_node(frame.f.var(), frame.neg, res);
+      tables.insert_computed_table(CT_COFACTOR, frame.f, frame.cube, bdd_ptr(), res);
+      stack.pop_back();
+      continue;
+    }
+
+    if (frame.next == 1)
+    {
+      frame.neg = res;
+    }
+    bdd_ptr child = (frame.next == 1) ? frame.f.pos_cf() : frame.f.neg_cf();
+    bdd_ptr child_cube = frame.cube;
+    ++frame.next;
+
+    // frame is invalid once the stack grows
+    if (!cofactor_lookup(tables, child, child_cube, res))
+    {
+      stack.push_back(cofactor_frame(child, child_cube));
+    }
+  }
+
+  return res;
+}
+
+// negative_cofactor takes the BDD pointed to by np, 
+// and returns the negative cofactor with respect to var.
+bdd_ptr negative_cofactor(bdd_ptr np, int var)
+{
+  return restrict(np, var, false);
 }
 
 // posative_cofactor takes the BDD pointed to by np, 
 // and returns the posative cofactor with respect to var.
-bdd_ptr positive_cofactor(bdd_ptr np, char var)
+bdd_ptr positive_cofactor(bdd_ptr np, int var)
 {
-  // get reference to tables
-  bdd_tables& tables = bdd_tables::getInstance();
-  
-  //... your code goes here
-  if (np->is_terminal()) return np;
-  if(np->var==var) return np->pos_cf;
-  if (!(np->has_var(var))) return np;
-
-  bdd_ptr root = tables.find_in_unique_table(np->var, bdd_node::zero, bdd_node::one);
-  bdd_ptr root_bar = apply(root, bdd_node::one, "xor");
-  bdd_ptr left = apply( root_bar, positive_cofactor(np->neg_cf, var), "and");
-  bdd_ptr right = apply( root, positive_cofactor(np->pos_cf, var), "and");
-  return apply( left, right, "or");
+  return restrict(np, var, true);
 }
 
 // boolean_difference takes the BDD pointed to by np, 
 // and returns the boolean difference with respect to var.
-bdd_ptr boolean_difference(bdd_ptr np, char var)
+bdd_ptr boolean_difference(bdd_ptr np, int var)
+{
+  bdd_op_scope scope;
+  return apply(restrict(np, var, true), restrict(np, var, false), OP_XOR);
+}
+
+
+// exists quantifies the vars of a cube out of f: it is f with each of them
+// replaced by 0, or by 1.  forall is the dual, f with each of them
+// replaced by 0, and by 1.  and_exists(f, g, cube) = exists(f g, cube), the
+// relational product, without building f g first: the conjunction and the
+// quantification are done in the same walk over f and g, so a var of the
+// cube is quantified out as soon as the walk gets to it.  exists is
+// and_exists with g = 1.
+//
+// at a level above the cube vars, a node is built for the results for the
+// children.  at a cube var, the results for the children are or'ed, and
+// the positive child isn't looked at if the result for the negative one is
+// already 1.  results are kept in the computed table under CT_AND_EXISTS,
+// keyed by f, g and the cube vars below the top of f and g.  like ite, the
+// pending calls are kept on an explicit stack
+static bdd_ptr and_exists_iter(bdd_tables& tables, bdd_ptr f, bdd_ptr g, bdd_ptr cube);
+
+bdd_ptr exists(bdd_ptr f, bdd_ptr cube)
 {
-  // get reference to tables
-  //bdd_tables& tables = bdd_tables::getInstance();
-  
-  //... your code goes here
-  return apply( positive_cofactor(np, var), negative_cofactor(np, var), "xor");
+  if (!is_cube(cube, true)) return bdd_ptr();
+  bdd_op_scope scope;
+  return and_exists_iter(bdd_tables::getInstance(), f, bdd_node::one(), cube);
 }
 
+bdd_ptr forall(bdd_ptr f, bdd_ptr cube)
+{
+  if (!is_cube(cube, true)) return bdd_ptr();
+  bdd_op_scope scope;
+  return and_exists_iter(bdd_tables::getInstance(), f.complement(), bdd_node::one(),
+                         cube).complement();
+}
+
+bdd_ptr and_exists(bdd_ptr f, bdd_ptr g, bdd_ptr cube)
+{
+  if (!is_cube(cube, true)) return bdd_ptr();
+  bdd_op_scope scope;
+  return and_exists_iter(bdd_tables::getInstance(), f, g, cube);
+}
+
+// the part of an and_exists call that comes before splitting: the terminal
+// cases, the cube vars above f and g and the computed table lookup.
+// returns true if the result is known, in res.  otherwise f, g and cube
+// are left as the key of the call: f precedes g, and g is 1 for plain
+// quantification
+static bool and_exists_lookup(bdd_tables& tables, bdd_ptr& f, bdd_ptr& g, bdd_ptr& cube,
+                              bdd_ptr& res)
+{
+  if (f.is_zero() || g.is_zero() || f == g.complement())
+  {
+    res = bdd_node::zero();
+    return true;
+  }
+  if (f == g) g = bdd_node::one();
+  if (precedes(tables, g, f)) std::swap(f, g);
+
+  if (cube.is_one())
+  {
+    res = g.is_one() ? f : ite_iter(tables, f, g, bdd_node::zero());
+    return true;
+  }
+  if (f.is_terminal())
+  {
+    // both are 1
+    res = f;
+    return true;
+  }
+
+  // cube vars above f and g don't matter
+  int top = tables.top_level(f);
+  while (tables.top_level(cube) < top)
+  {
+    bdd_ptr rest;
+    bool positive = split_cube(cube, rest);
+    assert(positive);
+    cube = rest;
+  }
+  if (cube.is_one())
+  {
+    res = g.is_one() ? f : ite_iter(tables, f, g, bdd_node::zero());
+    return true;
+  }
+
+  res = tables.find_in_computed_table(CT_AND_EXISTS, f, g, cube);
+  if (res) return true;
+  return false;
+}
+
+// an and_exists call waiting for the results for its children.  next is
+// the child to start next: 0 for the negative cofactors, 1 for the
+// positive ones, 2 once both are done
+struct and_exists_frame
+{
+  and_exists_frame(bdd_tables& tables, const bdd_ptr& f_in, const bdd_ptr& g_in,
+                   const bdd_ptr& cube_in) :
+    f(f_in), g(g_in), cube(cube_in), next(0)
+  {
+    top = tables.top_level(f);
+    quantify = (tables.top_level(cube) == top);
+  }
+
+  bdd_ptr f, g, cube;
+  int top;       // the level split on, that of f
+  bool quantify; // whether the var at top is in the cube
+  int next;
+  bdd_ptr neg; // the result for the negative cofactors, once known
+};
+
+// res always holds the result of the call that finished last, which the
+// frame on top of the stack picks up
+static bdd_ptr and_exists_iter(bdd_tables& tables, bdd_ptr f, bdd_ptr g, bdd_ptr cube)
+{
+  bdd_ptr res;
+  if (and_exists_lookup(tables, f, g, cube, res)) return res;
+
+  vector<and_exists_frame> stack(1, and_exists_frame(tables, f, g, cube));
+  while (!stack.empty())
+  {
+    and_exists_frame& frame = stack.back();
+
+    if (frame.next == 1)
+    {
+      frame.neg = res;
+      if (frame.quantify && res.is_one())
+      {
+        // the positive cofactors can't change an or with 1
+        frame.next = 2;
+      }
+    }
+
+    if (frame.next == 2)
+    {
+      if (!frame.quantify)
+      {
+        res = tables.get_node(tables.var_at_level(frame.top), frame.neg, res);
+      }
+      else if (!frame.neg.is_one())
+      {
+        res = ite_iter(tables, frame.neg, bdd_node::one(), res);
+      }
+      else
+      {
+        res = frame.neg;
+      }
+      tables.insert_computed_table(CT_AND_EXISTS, frame.f, frame.g, frame.cube, res);
+      stack.pop_back();
+      continue;
+    }
+
+    bool positive = (frame.next == 1);
+    bdd_ptr child_f = cofactor_at(tables, frame.f, frame.top, positive);
+    bdd_ptr child_g = cofactor_at(tables, frame.g, frame.top, positive);
+    bdd_ptr child_cube = frame.cube;
+    if (frame.quantify)
+    {
+      split_cube(frame.cube, child_cube);
+    }
+    ++frame.next;
+
+    // frame is invalid once the stack grows
+    if (!and_exists_lookup(tables, child_f, child_g, child_cube, res))
+    {
+      stack.push_back(and_exists_frame(tables, child_f, child_g, child_cube));
+    }
+  }
+
+  return res;
+}
+
+
+// influence computes, for every var x at once, the probability that the
+// boolean difference of f w.r.t. x is 1, when var i is 1 with probability
+// var_prob[i].  no nodes are created.
+//
+// every assignment of the other vars leads down the BDD either past x's
+// level, in which case f doesn't depend on x, or to a node v labeled x, in
+// which case the boolean difference is the xor of v's children.  the vars
+// above v and below it are independent, so
+//
+//   influence(x) = sum over the nodes v labeled x of path(v) P(hi ^ lo)
+//
+// where path(v) is the probability of reaching v from the root, found top
+// down, and P(hi ^ lo) = P(hi) + P(lo) - 2 P(hi lo).  the probability P(a)
+// of every node is found bottom up, and P(a b) by a walk over pairs of
+// nodes that is memoized across all of the nodes of f
+
+// node -> the probability of its (uncomplemented) function
+typedef map<bdd_node*, double> node_probabilities;
+
+// <edge, edge> -> the probability that both are 1.  edges are keyed by
+// their node's id and complement bit
+typedef map<pair<unsigned int, unsigned int>, double> pair_probabilities;
+
+// orders nodes top level first, then by id
+struct level_order
+{
+  level_order(const bdd_tables& tables_in) : tables(tables_in) {}
+
+  bool operator() (bdd_node* a, bdd_node* b) const
+  {
+    int a_level = tables.level(a->var);
+    int b_level = tables.level(b->var);
+    if (a_level != b_level) return a_level < b_level;
+    return a->get_id() < b->get_id();
+  }
+
+  const bdd_tables& tables;
+};
+
+// the non-terminal nodes reachable from f, top level first
+static void collect_nodes(const bdd_tables& tables, const bdd_ptr& f, vector<bdd_node*>& nodes)
+{
+  set<bdd_node*> visited;
+  vector<bdd_node*> stack(1, f.node());
+  while (!stack.empty())
+  {
+    bdd_node* n = stack.back();
+    stack.pop_back();
+    if (n->is_terminal() || !visited.insert(n).second) continue;
+
+    nodes.push_back(n);
+    stack.push_back(n->neg_cf.node());
+    stack.push_back(n->pos_cf.node());
+  }
+  sort(nodes.begin(), nodes.end(), level_order(tables));
+}
+
+static double edge_probability(const node_probabilities& prob, const bdd_ptr& edge)
+{
+  double p = edge.is_terminal() ? 1 : prob.find(edge.node())->second;
+  return edge.is_complemented() ? 1 - p : p;
+}
+
+// the probability of every one of nodes (ordered top level first), found
+// bottom up
+static void node_probabilities_of(const vector<bdd_node*>& nodes, const vector<double>& var_prob,
+                                  node_probabilities& prob)
+{
+  for (vector<bdd_node*>::const_reverse_iterator it = nodes.rbegin(); it != nodes.rend(); ++it)
+  {
+    bdd_node* n = *it;
+    double p = var_prob[n->var];
+    prob[n] = (1 - p) * edge_probability(prob, n->neg_cf) + p * edge_probability(prob, n->pos_cf);
+  }
+}
+
+static unsigned int edge_key(const bdd_ptr& edge)
+{
+  return ((unsigned int)edge.get_id() << 1) | (edge.is_complemented() ? 1 : 0);
+}
+
+// the part of a pair walk that comes before splitting.  returns true if
+// P(f g) is known, in res.  otherwise f and g are ordered as the memo key
+static bool and_probability_lookup(const node_probabilities& prob, const pair_probabilities& memo,
+                                   bdd_ptr& f, bdd_ptr& g, double& res)
+{
+  if (f.is_zero() || g.is_zero() || f == g.complement()) { res = 0; return true; }
+  if (f.is_one()) { res = edge_probability(prob, g); return true; }
+  if (g.is_one() || f == g) { res = edge_probability(prob, f); return true; }
+
+  if (edge_key(g) < edge_key(f)) std::swap(f, g);
+  pair_probabilities::const_iterator it = memo.find(make_pair(edge_key(f), edge_key(g)));
+  if (it == memo.end()) return false;
+  res = it->second;
+  return true;
+}
+
+// a pair of edges waiting for the results for its cofactors.  next is the
+// half to start next: 0 for the negative cofactors, 1 for the positive
+// ones, 2 once both are done
+struct and_probability_frame
+{
+  and_probability_frame(const bdd_ptr& f_in, const bdd_ptr& g_in, int top_in) :
+    f(f_in), g(g_in), top(top_in), next(0), neg(0)
+  {}
+
+  bdd_ptr f, g;
+  int top;    // the level split on
+  int next;
+  double neg; // the result for the negative cofactors, once known
+};
+
+// the probability that both f and g are 1.  the pending pairs are kept on
+// an explicit stack, like in ite
+static double and_probability(const bdd_tables& tables, const vector<double>& var_prob,
+                              const node_probabilities& prob, pair_probabilities& memo,
+                              bdd_ptr f, bdd_ptr g)
+{
+  double res;
+  if (and_probability_lookup(prob, memo, f, g, res)) return res;
+
+  vector<and_probability_frame> stack;
+  stack.push_back(and_probability_frame(f, g, min(tables.top_level(f), tables.top_level(g))));
+  while (!stack.empty())
+  {
+    and_probability_frame& frame = stack.back();
+
+    if (frame.next == 2)
+    {
+      double p = var_prob[tables.var_at_level(frame.top)];
+      res = (1 - p) * frame.neg + p * res;
+      memo[make_pair(edge_key(frame.f), edge_key(frame.g))] = res;
+      stack.pop_back();
+      continue;
+    }
+
+    if (frame.next == 1)
+    {
+      frame.neg = res;
+    }
+    bool positive = (frame.next == 1);
+    ++frame.next;
+
+    bdd_ptr f1 = cofactor_at(tables, frame.f, frame.top, positive);
+    bdd_ptr g1 = cofactor_at(tables, frame.g, frame.top, positive);
+
+    // frame is invalid once the stack grows
+    if (!and_probability_lookup(prob, memo, f1, g1, res))
+    {
+      stack.push_back(and_probability_frame(f1, g1, min(tables.top_level(f1), tables.top_level(g1))));
+    }
+  }
+
+  return res;
+}
+
+vector<double> influence(bdd_ptr f, const vector<double>& var_prob)
+{
+  bdd_tables& tables = bdd_tables::getInstance();
+  assert((int)var_prob.size() == tables.num_vars());
+
+  vector<double> result(tables.num_vars(), 0);
+
+  vector<bdd_node*> nodes;
+  collect_nodes(tables, f, nodes);
+
+  // bottom up: the probability of every node
+  node_probabilities prob;
+  node_probabilities_of(nodes, var_prob, prob);
+
+  // top down: the probability of reaching every node, and its share of
+  // the influence of its var
+  node_probabilities path;
+  pair_probabilities memo;
+  if (!nodes.empty())
+  {
+    path[nodes.front()] = 1;
+  }
+  for (vector<bdd_node*>::iterator it = nodes.begin(); it != nodes.end(); ++it)
+  {
+    bdd_node* n = *it;
+    double p = var_prob[n->var];
+    double reach = path[n];
+
+    if (!n->neg_cf.is_terminal()) path[n->neg_cf.node()] += reach * (1 - p);
+    if (!n->pos_cf.is_terminal()) path[n->pos_cf.node()] += reach * p;
+
+    double diff = edge_probability(prob, n->neg_cf) + edge_probability(prob, n->pos_cf) -
+                  2 * and_probability(tables, var_prob, prob, memo, n->neg_cf, n->pos_cf);
+    result[n->var] += reach * diff;
+  }
+
+  return result;
+}
+
+vector<double> influence(bdd_ptr f)
+{
+  return influence(f, vector<double>(bdd_tables::getInstance().num_vars(), 0.5));
+}
+
+
+// probability and sat_count make one bottom-up pass over the nodes of f,
+// memoizing the value of every node.  nothing is kept between calls, and
+// no nodes are created.
+
+double probability(bdd_ptr f, const vector<double>& var_prob)
+{
+  bdd_tables& tables = bdd_tables::getInstance();
+  assert((int)var_prob.size() == tables.num_vars());
+
+  vector<bdd_node*> nodes;
+  collect_nodes(tables, f, nodes);
+
+  node_probabilities prob;
+  node_probabilities_of(nodes, var_prob, prob);
+  return edge_probability(prob, f);
+}
+
+double probability(bdd_ptr f)
+{
+  return probability(f, vector<double>(bdd_tables::getInstance().num_vars(), 0.5));
+}
+
+// node -> the number of assignments to the vars at and below its level
+// that make its (uncomplemented) function 1
+typedef map<bdd_node*, long double> node_counts;
+
+// the number of BDD vars at the levels above each level, and, last, in
+// all.  ZDD vars (see bdd_zdd.h) aren't vars of the functions counted, so
+// they don't double the counts
+static vector<int> count_levels(const bdd_tables& tables)
+{
+  vector<int> levels(tables.num_vars() + 1, 0);
+  for (int level = 0; level < tables.num_vars(); ++level)
+  {
+    levels[level + 1] = levels[level] + (tables.is_zdd_var(tables.var_at_level(level)) ? 0 : 1);
+  }
+  return levels;
+}
+
+// the count level of edge's node, where the terminal is one level below
+// the last var
+static int count_level(const bdd_tables& tables, const vector<int>& levels, const bdd_ptr& edge)
+{
+  return levels[edge.is_terminal() ? tables.num_vars() : tables.level(edge.var())];
+}
+
+// the number of assignments to the vars at and below level that make edge 1.
+// the vars between level and edge's node are free, each one doubles the
+// count.  the count of a complemented edge is what is left of the
+// assignments below its node
+static long double edge_count(const bdd_tables& tables, const vector<int>& levels,
+                              const node_counts& counts, const bdd_ptr& edge, int level)
+{
+  int edge_level = count_level(tables, levels, edge);
+  long double c = edge.is_terminal() ? 1 : counts.find(edge.node())->second;
+  if (edge.is_complemented())
+  {
+    c = ldexp((long double)1, levels.back() - edge_level) - c;
+  }
+  return ldexp(c, edge_level - level);
+}
+
+long double sat_count(bdd_ptr f)
+{
+  bdd_tables& tables = bdd_tables::getInstance();
+  vector<int> levels = count_levels(tables);
+
+  vector<bdd_node*> nodes;
+  collect_nodes(tables, f, nodes);
+
+  node_counts counts;
+  for (vector<bdd_node*>::reverse_iterator it = nodes.rbegin(); it != nodes.rend(); ++it)
+  {
+    bdd_node* n = *it;
+    int below = levels[tables.level(n->var) + 1];
+    counts[n] = edge_count(tables, levels, counts, n->neg_cf, below) +
+                edge_count(tables, levels, counts, n->pos_cf, below);
+  }
+  return edge_count(tables, levels, counts, f, 0);
+}
+
+
+// support_cube gives the vars f depends on as a cube, the conjunction of
+// those vars.  the cube of a node is its var and the union of the cubes of
+// its children, so it is found bottom up, one node at a time.  the cube of
+// every node is kept in the computed table under CT_SUPPORT, keyed by the
+// (regular) node: cubes are shared between BDDs, and the support of a BDD
+// is only worked out for the nodes whose cube isn't cached yet.  a cube
+// has one node per var, so a membership test (see bdd_ptr::has_var) walks
+// at most that many nodes
+
+// the union of two cubes of positive literals, i.e. their conjunction.
+// the vars are merged in level order, and the result is built from the
+// bottom up
+static bdd_ptr cube_union(bdd_tables& tables, bdd_ptr a, bdd_ptr b)
+{
+  if (a.is_one() || a == b) return b;
+  if (b.is_one()) return a;
+
+  vector<int> vars;
+  while (!a.is_one() || !b.is_one())
+  {
+    int a_level = tables.top_level(a);
+    int b_level = tables.top_level(b);
+    if (a_level <= b_level)
+    {
+      vars.push_back(a.var());
+      a = a.pos_cf();
+      if (a_level == b_level) b = b.pos_cf();
+    }
+    else
+    {
+      vars.push_back(b.var());
+      b = b.pos_cf();
+    }
+  }
+
+  bdd_ptr cube = bdd_node::one();
+  for (vector<int>::reverse_iterator it = vars.rbegin(); it != vars.rend(); ++it)
+  {
+    cube = tables.get_node(*it, bdd_node::zero(), cube);
+  }
+  return cube;
+}
+
+bdd_ptr support_cube(bdd_ptr f)
+{
+  bdd_op_scope scope;
+  bdd_tables& tables = bdd_tables::getInstance();
+  if (f.is_terminal()) return bdd_node::one();
+
+  // node -> its cube, for the nodes below f that are needed.  the cubes
+  // found in the computed table are kept here, since the uncached ones
+  // that are inserted may overwrite them
+  map<bdd_node*, bdd_ptr> cubes;
+  vector<bdd_node*> uncached;
+
+  vector<bdd_node*> stack(1, f.node());
+  while (!stack.empty())
+  {
+    bdd_node* n = stack.back();
+    stack.pop_back();
+    if (n->is_terminal() || cubes.count(n)) continue;
+
+    bdd_ptr cached = tables.find_in_computed_table(CT_SUPPORT, n, bdd_ptr());
+    cubes[n] = cached;
+    if (!cached)
+    {
+      uncached.push_back(n);
+      stack.push_back(n->neg_cf.node());
+      stack.push_back(n->pos_cf.node());
+    }
+  }
+
+  // bottom up, so the cubes of the children are known
+  sort(uncached.begin(), uncached.end(), level_order(tables));
+  for (vector<bdd_node*>::reverse_iterator it = uncached.rbegin(); it != uncached.rend(); ++it)
+  {
+    bdd_node* n = *it;
+    bdd_ptr neg = n->neg_cf.is_terminal() ? bdd_node::one() : cubes[n->neg_cf.node()];
+    bdd_ptr pos = n->pos_cf.is_terminal() ? bdd_node::one() : cubes[n->pos_cf.node()];
+
+    // n's var is above those of its children
+    bdd_ptr cube = tables.get_node(n->var, bdd_node::zero(), cube_union(tables, neg, pos));
+    tables.insert_computed_table(CT_SUPPORT, n, bdd_ptr(), bdd_ptr(), cube);
+    cubes[n] = cube;
+  }
+
+  return cubes[f.node()];
+}
+
+vector<int> support(bdd_ptr f)
+{
+  vector<int> vars;
+  for (bdd_ptr cube = support_cube(f); !cube.is_one(); cube = cube.pos_cf())
+  {
+    vars.push_back(cube.var());
+  }
+  return vars;
+}
+
+
+// compose and vector_compose substitute for the vars of f in a single walk
+// over it, bottom up: the result for a node labeled x is ite(g, the result
+// for its then child, the result for its else child), where g is the
+// function substituted for x, or x itself.  the nodes below the lowest var
+// that is substituted for are left as they are, and a complemented edge
+// gets the complement of the result for its node.  the results of
+// compose are also kept in the computed table under CT_COMPOSE, keyed by
+// the node, g and var, so they are shared between calls
+
+// the result for edge, given the results for the nodes of the walk
+static bdd_ptr composed(const map<bdd_node*, bdd_ptr>& results, const bdd_ptr& edge)
+{
+  map<bdd_node*, bdd_ptr>::const_iterator it = results.find(edge.node());
+  if (it == results.end()) return edge;
+  return edge.is_complemented() ? it->second.complement() : it->second;
+}
+
+// key_g and key_var are the key of compose's entries, or null for
+// vector_compose
+static bdd_ptr compose_walk(bdd_tables& tables, const bdd_ptr& f, const vector<bdd_ptr>& subst,
+                            int bottom, const bdd_ptr& key_g, const bdd_ptr& key_var)
+{
+  map<bdd_node*, bdd_ptr> results;
+  vector<bdd_node*> pending;
+
+  vector<bdd_node*> stack(1, f.node());
+  while (!stack.empty())
+  {
+    bdd_node* n = stack.back();
+    stack.pop_back();
+    if (n->is_terminal() || tables.level(n->var) > bottom || results.count(n)) continue;
+
+    bdd_ptr cached;
+    if (key_var) cached = tables.find_in_computed_table(CT_COMPOSE, n, key_g, key_var);
+    results[n] = cached;
+    if (!cached)
+    {
+      pending.push_back(n);
+      stack.push_back(n->neg_cf.node());
+      stack.push_back(n->pos_cf.node());
+    }
+  }
+
+  // bottom up, so the results for the children are known
+  sort(pending.begin(), pending.end(), level_order(tables));
+  for (vector<bdd_node*>::reverse_iterator it = pending.rbegin(); it != pending.rend(); ++it)
+  {
+    bdd_node* n = *it;
+    bdd_ptr neg = composed(results, n->neg_cf);
+    bdd_ptr pos = composed(results, n->pos_cf);
+    int var = n->var;
+    bdd_ptr g = (var < (int)subst.size()) ? subst[var] : bdd_ptr();
+
+    bdd_ptr res;
+    int var_level = tables.level(var);
+    if (!g && tables.top_level(neg) > var_level && tables.top_level(pos) > var_level)
+    {
+      // the children are still below var
+      res = tables.get_node(var, neg, pos);
+    }
+    else
+    {
+      res = ite_iter(tables, g ? g : tables.var_bdd(var), pos, neg);
+    }
+
+    if (key_var) tables.insert_computed_table(CT_COMPOSE, n, key_g, key_var, res);
+    results[n] = res;
+  }
+
+  return composed(results, f);
+}
+
+bdd_ptr compose(bdd_ptr f, int var, bdd_ptr g)
+{
+  bdd_op_scope scope;
+  bdd_tables& tables = bdd_tables::getInstance();
+  bdd_ptr literal = tables.var_bdd(var);
+  if (g == literal) return f;
+
+  vector<bdd_ptr> subst(var + 1);
+  subst[var] = g;
+  return compose_walk(tables, f, subst, tables.level(var), g, literal);
+}
+
+// whether g is the BDD of var itself, found without making that node
+static bool is_var_bdd(const bdd_ptr& g, int var)
+{
+  return !g.is_terminal() && !g.is_complemented() && g.var() == var &&
+         g.neg_cf().is_zero() && g.pos_cf().is_one();
+}
+
+bdd_ptr vector_compose(bdd_ptr f, const vector<bdd_ptr>& subst)
+{
+  bdd_op_scope scope;
+  bdd_tables& tables = bdd_tables::getInstance();
+
+  // the level of the lowest var that is substituted for
+  int bottom = -1;
+  int num_vars = min((int)subst.size(), tables.num_vars());
+  for (int var = 0; var < num_vars; ++var)
+  {
+    if (subst[var] && !is_var_bdd(subst[var], var)) bottom = max(bottom, tables.level(var));
+  }
+  if (bottom < 0) return f;
+
+  return compose_walk(tables, f, subst, bottom, bdd_ptr(), bdd_ptr());
+}
 
 // sort_by_influence calculates the influence of all the variables in np
 // and displays them in descending order (most influent variable is
-// shown first). For this task you can assume the number of variable
-// is no greater than 20.
+// shown first).
 
 class varList {
 public:
   varList(){}
-  varList(float prob, char var) {
+  varList(float prob, const string& name) {
     this->prob = prob; 
-    this->var = var;
+    this->name = name;
   }
 
   float prob;
-  char var;
+  string name;
 };
 
 bool Greater(const varList& a, const varList& b) {
-  if(a.prob == b.prob)  return a.var < b.var;
+  if(a.prob == b.prob)  return a.name < b.name;
   return a.prob > b.prob;
 }
 
 bdd_ptr sort_by_influence(bdd_ptr np)
 {
-  //... your code goes here
-  char var_all[64] = {"abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ1234567890_"};
-  vector<varList> vecList;
+  bdd_op_scope scope;
+  bdd_tables& tables = bdd_tables::getInstance();
 
-  float prob;
-  for (int i = 0; i < 64; i++) {
-    if (np->has_var(var_all[i])) {
-      bdd_ptr tmp = boolean_difference(np, var_all[i]);
-      prob = tmp->probability;
+  vector<varList> vecList;
 
-      vecList.push_back(varList(prob,var_all[i]));
-    }
+  vector<int> vars = support(np);
+  vector<double> infl = influence(np);
+  for (size_t i = 0; i < vars.size(); i++) {
+    vecList.push_back(varList(infl[vars[i]], tables.var_name(vars[i])));
   }
 
   sort(vecList.begin(),vecList.end(),Greater);
   for(size_t i=0; i<vecList.size(); ++i)
-    cout << vecList[i].var << "," << vecList[i].prob << endl;
+    cout << vecList[i].name << "," << vecList[i].prob << endl;
 
   // this function does not alter the current node, so np must be
   // returned at the end
@@ -5,16 +5,71 @@
 #include "operation.h"
 #include "bdd_tables.h"
 #include <iostream>
+#include <vector>
 #include <assert.h>
 #include <stdlib.h>
 
-// prototypes
+// prototypes.  the operations work on the BDDs of the calling thread's
+// current manager (see bdd_manager.h)
+bdd_ptr ite(bdd_ptr f, bdd_ptr g, bdd_ptr h);
+bdd_ptr ite_recursive(bdd_ptr f, bdd_ptr g, bdd_ptr h);
+
+// the number of threads ite (and so apply) runs on.  1, the default, runs
+// everything on the calling thread
+void set_num_threads(int n);
+
 bdd_ptr apply(bdd_ptr bdd1, bdd_ptr bdd2, std::string o);
 bdd_ptr apply(bdd_ptr bdd1, bdd_ptr bdd2, operation &op);
+bdd_ptr apply(bdd_ptr bdd1, bdd_ptr bdd2, int code);
+
+// whether cube is a conjunction of literals, or of vars if vars_only is
+// set.  1 is the empty conjunction; 0 is no cube
+bool is_cube(bdd_ptr cube, bool vars_only = false);
+
+// f with var set to value, and f with the vars of cube set to make the
+// cube true.  cofactor returns a null bdd_ptr if cube isn't a conjunction
+// of literals
+bdd_ptr restrict(bdd_ptr f, int var, bool value);
+bdd_ptr cofactor(bdd_ptr f, bdd_ptr cube);
+
+bdd_ptr negative_cofactor(bdd_ptr np, int var);
+bdd_ptr positive_cofactor(bdd_ptr np, int var);
+bdd_ptr boolean_difference(bdd_ptr np, int var);
+
+// f with the vars of cube quantified out existentially (exists) or
+// universally (forall), and exists(f g, cube) without building f g.  they
+// return a null bdd_ptr if cube isn't a conjunction of vars
+bdd_ptr exists(bdd_ptr f, bdd_ptr cube);
+bdd_ptr forall(bdd_ptr f, bdd_ptr cube);
+bdd_ptr and_exists(bdd_ptr f, bdd_ptr g, bdd_ptr cube);
+
+// the vars f depends on, as a cube (the conjunction of the vars), and in
+// level order
+bdd_ptr support_cube(bdd_ptr f);
+std::vector<int> support(bdd_ptr f);
+
+// f with the function g substituted for var, and f with subst[i]
+// substituted for every var i at once (a null bdd_ptr, or a subst shorter
+// than the number of vars, leaves var i as it is)
+bdd_ptr compose(bdd_ptr f, int var, bdd_ptr g);
+bdd_ptr vector_compose(bdd_ptr f, const std::vector<bdd_ptr>& subst);
+
+// the influence of every var on f (the probability that the boolean
+// difference w.r.t. it is 1), indexed by var, when var i is 1 with
+// probability var_prob[i], or .5 if no probabilities are given
+std::vector<double> influence(bdd_ptr f, const std::vector<double>& var_prob);
+std::vector<double> influence(bdd_ptr f);
+
+// the probability that f is 1 when var i is 1 with probability
+// var_prob[i], or .5 if no probabilities are given
+double probability(bdd_ptr f, const std::vector<double>& var_prob);
+double probability(bdd_ptr f);
+
+// the number of assignments to all of the vars that make f 1, the ZDD
+// vars of bdd_zdd.h left out.  it is exact up to 2^64, beyond that it is
+// rounded to 64 significant bits
+long double sat_count(bdd_ptr f);
 
-bdd_ptr negative_cofactor(bdd_ptr np, char var);
-bdd_ptr positive_cofactor(bdd_ptr np, char var);
-bdd_ptr boolean_difference(bdd_ptr np, char var);
 bdd_ptr sort_by_influence(bdd_ptr np);
 
 